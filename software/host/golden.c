@@ -0,0 +1,232 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * golden.c: Checks the concentration and HDC1080 conversions
+ *           against golden vectors and measures their throughput
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "sim.h"
+
+#include "gas.h"
+#include "hdc1080.h"
+#include "slope.h"
+#include "lmp91000.h"
+
+// The golden vectors are generated by golden_vectors.py, an independent
+// reference implementation. Every vector is run through the firmware
+// function, concentrations have to match within GOLDEN_TOLERANCE_RELATIVE
+// (or GOLDEN_TOLERANCE_ABSOLUTE around zero), the integer HDC1080
+// conversions have to match exactly.
+//
+// Afterwards the throughput of every conversion is measured over all vectors.
+// For the concentration it is measured with the coefficients recalculated
+// for every conversion (gas type, gain and temperature change with every
+// vector) and with cached coefficients (only the ADC count changes, as
+// between two temperature measurements on the Bricklet).
+
+#define GOLDEN_TOLERANCE_RELATIVE 1e-9
+#define GOLDEN_TOLERANCE_ABSOLUTE 1e-6  // in ppb
+#define GOLDEN_MAX_VECTORS        8192
+#define GOLDEN_MAX_PRINTED_ERRORS 20
+#define GOLDEN_BENCHMARK_TIME     0.5   // in s per variant
+
+typedef enum {
+	GOLDEN_KIND_PPB,
+	GOLDEN_KIND_TEMPERATURE,
+	GOLDEN_KIND_HUMIDITY
+} GoldenKind;
+
+typedef struct {
+	GoldenKind kind;
+	uint8_t  type;
+	uint8_t  tia_gain;
+	int16_t  temperature;
+	int32_t  adc_count;
+	int32_t  adc_count_zero;
+	int32_t  sensitivity;
+	uint16_t raw;
+	double   expected;
+} GoldenVector;
+
+static GoldenVector golden_vectors[GOLDEN_MAX_VECTORS];
+static uint32_t golden_vector_count = 0;
+
+static bool golden_read(const char *path) {
+	FILE *file = fopen(path, "r");
+	if(file == NULL) {
+		perror(path);
+		return false;
+	}
+
+	char line[256];
+	while(fgets(line, sizeof(line), file) != NULL) {
+		if(golden_vector_count >= GOLDEN_MAX_VECTORS) {
+			fprintf(stderr, "Too many vectors in %s\n", path);
+			fclose(file);
+			return false;
+		}
+
+		GoldenVector *vector = &golden_vectors[golden_vector_count];
+		unsigned int type, tia_gain, raw;
+		int temperature, adc_count, adc_count_zero, sensitivity;
+
+		if(sscanf(line, "ppb,%u,%u,%d,%d,%d,%d,%lf", &type, &tia_gain, &temperature, &adc_count, &adc_count_zero, &sensitivity, &vector->expected) == 7) {
+			vector->kind           = GOLDEN_KIND_PPB;
+			vector->type           = type;
+			vector->tia_gain       = tia_gain;
+			vector->temperature    = temperature;
+			vector->adc_count      = adc_count;
+			vector->adc_count_zero = adc_count_zero;
+			vector->sensitivity    = sensitivity;
+		} else if(sscanf(line, "temperature,%u,%lf", &raw, &vector->expected) == 2) {
+			vector->kind           = GOLDEN_KIND_TEMPERATURE;
+			vector->raw            = raw;
+		} else if(sscanf(line, "humidity,%u,%lf", &raw, &vector->expected) == 2) {
+			vector->kind           = GOLDEN_KIND_HUMIDITY;
+			vector->raw            = raw;
+		} else {
+			continue; // Comment
+		}
+
+		golden_vector_count++;
+	}
+
+	fclose(file);
+	return true;
+}
+
+static double golden_calculate(const GoldenVector *vector) {
+	switch(vector->kind) {
+		case GOLDEN_KIND_PPB: {
+			// The TIA gain is taken from the TIACN register value of the sensor table
+			gas.type           = vector->type;
+			gas.sensor_table[vector->type].lmp91000[0] = (vector->tia_gain << 2) | (lmp91000_default_configuration[vector->type][0] & 0b11);
+			gas.temperature    = vector->temperature;
+			gas.adc_count      = vector->adc_count;
+			gas.adc_count_zero = vector->adc_count_zero;
+			gas.na_per_ppm     = vector->sensitivity;
+			gas_update_coefficients();
+			gas_calculate_ppb();
+
+			return gas.ppb;
+		}
+
+		case GOLDEN_KIND_TEMPERATURE: return hdc1080_temperature_from_raw(vector->raw);
+		case GOLDEN_KIND_HUMIDITY:    return hdc1080_humidity_from_raw(vector->raw);
+	}
+
+	return NAN;
+}
+
+static bool golden_is_equal(const GoldenVector *vector, const double value) {
+	if(vector->kind != GOLDEN_KIND_PPB) {
+		return value == vector->expected;
+	}
+
+	const double difference = fabs(value - vector->expected);
+	return (difference <= GOLDEN_TOLERANCE_ABSOLUTE) || (difference <= fabs(vector->expected)*GOLDEN_TOLERANCE_RELATIVE);
+}
+
+static double golden_time(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+static double golden_calculate_cached(const GoldenVector *vector) {
+	gas.adc_count = vector->adc_count;
+	gas_calculate_ppb();
+
+	return gas.ppb;
+}
+
+static void golden_benchmark(const char *name, const GoldenKind kind, double (*calculate)(const GoldenVector *vector)) {
+	static const GoldenVector *vectors[GOLDEN_MAX_VECTORS];
+	uint32_t count = 0;
+	for(uint32_t i = 0; i < golden_vector_count; i++) {
+		if(golden_vectors[i].kind == kind) {
+			vectors[count++] = &golden_vectors[i];
+		}
+	}
+
+	volatile double sink = 0.0;
+	uint64_t conversions = 0;
+
+	const double start = golden_time();
+	double elapsed     = 0.0;
+	do {
+		for(uint32_t i = 0; i < count; i++) {
+			sink = sink + calculate(vectors[i]);
+		}
+
+		conversions += count;
+		elapsed      = golden_time() - start;
+	} while(elapsed < GOLDEN_BENCHMARK_TIME);
+
+	printf("%-38s %12.0f conversions/s\n", name, conversions/elapsed);
+}
+
+int main(int argc, char **argv) {
+	if(!golden_read(argc > 1 ? argv[1] : "golden_vectors.csv")) {
+		return 1;
+	}
+
+	sim_init();
+	slope_init();
+
+	// The EEPROM of the simulation is empty, the default sensor tables are used
+	gas_sensor_table_read();
+
+	uint32_t errors = 0;
+	for(uint32_t i = 0; i < golden_vector_count; i++) {
+		const GoldenVector *vector = &golden_vectors[i];
+		const double value         = golden_calculate(vector);
+
+		if(!golden_is_equal(vector, value)) {
+			if(errors < GOLDEN_MAX_PRINTED_ERRORS) {
+				if(vector->kind == GOLDEN_KIND_PPB) {
+					fprintf(stderr, "ppb: type %u, tia gain %u, temperature %d, adc count %d, zero %d, sensitivity %d: %.17g != %.17g\n",
+					        vector->type, vector->tia_gain, vector->temperature, vector->adc_count, vector->adc_count_zero, vector->sensitivity, value, vector->expected);
+				} else {
+					fprintf(stderr, "%s: raw %u: %.0f != %.0f\n", vector->kind == GOLDEN_KIND_TEMPERATURE ? "temperature" : "humidity", vector->raw, value, vector->expected);
+				}
+			}
+
+			errors++;
+		}
+	}
+
+	printf("%u vectors, %u errors\n", golden_vector_count, errors);
+	if(errors > 0) {
+		return 1;
+	}
+
+	golden_benchmark("gas_calculate_ppb, new coefficients", GOLDEN_KIND_PPB,         golden_calculate);
+	golden_benchmark("gas_calculate_ppb, cached",           GOLDEN_KIND_PPB,         golden_calculate_cached);
+	golden_benchmark("hdc1080_temperature_from_raw",        GOLDEN_KIND_TEMPERATURE, golden_calculate);
+	golden_benchmark("hdc1080_humidity_from_raw",           GOLDEN_KIND_HUMIDITY,    golden_calculate);
+
+	return 0;
+}
@@ -0,0 +1,86 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+# Generates golden_vectors.csv for the golden harness (golden.c).
+#
+# This is an independent reference implementation of the concentration
+# and HDC1080 conversions of the firmware, written from the formulas and
+# not from the C code. The vectors cover every gas type, every TIA gain,
+# temperatures below, at and above the compensation threshold and the
+# ADC extremes.
+#
+# Only regenerate the table if the conversion is changed on purpose.
+
+import sys
+
+ADC_18BIT_MAX = 262143
+ADC_REFERENCE = 2.048 # V
+TEMPERATURE_THRESHOLD = 25.0 # °C, zero and span compensation switch between low and high
+
+# LMP91000 TIA gain setting to feedback resistor in Ohm, gain 0 is the external resistor
+TIA_GAIN_TO_RGAIN = [499000, 2735, 3476, 6903, 13618, 32706, 96737, 205713]
+
+# Per gas type: zero drift in nA/°C (low, high) and span drift in %/°C (low, high)
+COMPENSATION = [
+    (0.0,   2.375, 0.6, 0.4), # CO
+    (1.7,  22.5,   1.2, 0.0), # EtOH
+    (0.0,   0.0,   0.3, 0.0), # H2S
+    (0.0,  15.0,   1.2, 0.5), # SO2
+    (0.0,  -1.6,   0.0, 0.4), # NO2
+    (0.0,   0.0,   0.0, 0.5), # O3
+    (0.0,   0.0,   0.0, 0.0), # IAQ
+    (0.0,   0.0,   0.0, 0.0), # RESP
+    (0.0,   0.0,   0.0, 0.0), # O3/NO2
+]
+
+# Sensitivity in nA/ppm*100, one typical value per gas type
+SENSITIVITY = [475, 290, 8000, 1200, -2500, -1500, 60, 600, -2000]
+
+ADC_COUNT_ZERO = 1000
+ADC_COUNTS = [0, 1, ADC_COUNT_ZERO, ADC_18BIT_MAX // 2, ADC_18BIT_MAX - 1, ADC_18BIT_MAX]
+TEMPERATURES = [-4000, 0, 2499, 2500, 2501, 8500] # °C/100
+
+HDC1080_RAW = [0, 1, 2, 0x3FFF, 0x4000, 0x7FFF, 0x8000, 0xC000, 0xFFFC, 0xFFFE, 0xFFFF]
+
+def reference_ppb(gas_type, tia_gain, temperature, adc_count, adc_count_zero, sensitivity):
+    t = temperature / 100.0
+    zero_low, zero_high, span_low, span_high = COMPENSATION[gas_type]
+    zero_drift = zero_low if t < TEMPERATURE_THRESHOLD else zero_high # nA/°C
+    span_drift = span_low if t < TEMPERATURE_THRESHOLD else span_high # %/°C
+
+    # Sensor current in nA through the TIA feedback resistor
+    current = (adc_count - adc_count_zero) * ADC_REFERENCE / ADC_18BIT_MAX / TIA_GAIN_TO_RGAIN[tia_gain] * 1e9
+    current -= zero_drift * (t - TEMPERATURE_THRESHOLD)
+    current *= 1.0 - span_drift / 100.0 * (t - TEMPERATURE_THRESHOLD)
+
+    return current / (sensitivity / 100.0) * 1000.0
+
+def reference_temperature(raw):
+    # °C/100, truncated like the integer arithmetic on the Bricklet
+    return raw * 16500 // 65536 - 4000
+
+def reference_humidity(raw):
+    # %RH/100
+    return raw * 10000 // 65536
+
+if __name__ == "__main__":
+    path = sys.argv[1] if len(sys.argv) > 1 else "golden_vectors.csv"
+
+    with open(path, "w") as f:
+        f.write("# Generated by golden_vectors.py, do not edit\n")
+        f.write("# ppb,type,tia_gain,temperature,adc_count,adc_count_zero,sensitivity,expected_ppb\n")
+        f.write("# temperature,raw,expected\n")
+        f.write("# humidity,raw,expected\n")
+
+        for gas_type in range(len(COMPENSATION)):
+            for tia_gain in range(len(TIA_GAIN_TO_RGAIN)):
+                for temperature in TEMPERATURES:
+                    for adc_count in ADC_COUNTS:
+                        ppb = reference_ppb(gas_type, tia_gain, temperature, adc_count, ADC_COUNT_ZERO, SENSITIVITY[gas_type])
+                        f.write("ppb,{0},{1},{2},{3},{4},{5},{6!r}\n".format(gas_type, tia_gain, temperature, adc_count, ADC_COUNT_ZERO, SENSITIVITY[gas_type], ppb))
+
+        for raw in HDC1080_RAW:
+            f.write("temperature,{0},{1}\n".format(raw, reference_temperature(raw)))
+
+        for raw in HDC1080_RAW:
+            f.write("humidity,{0},{1}\n".format(raw, reference_humidity(raw)))
@@ -0,0 +1,55 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * bootloader.h: Host replacement for the bricklib2 bootloader API
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef BOOTLOADER_H
+#define BOOTLOADER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define EEPROM_PAGE_SIZE 256
+#define EEPROM_PAGE_NUM  4
+
+typedef enum {
+	HANDLE_MESSAGE_RESPONSE_NONE,
+	HANDLE_MESSAGE_RESPONSE_EMPTY,
+	HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE,
+	HANDLE_MESSAGE_RESPONSE_NOT_SUPPORTED,
+	HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER
+} BootloaderHandleMessageResponse;
+
+typedef struct {
+	uint32_t message_pending; // Simulated SPITFP send buffer, see sim.c
+} SPITFP;
+
+typedef struct {
+	SPITFP st;
+} BootloaderStatus;
+
+extern BootloaderStatus bootloader_status;
+
+uint32_t bootloader_get_uid(void);
+bool bootloader_spitfp_is_send_possible(SPITFP *st);
+void bootloader_spitfp_send_ack_and_message(BootloaderStatus *bs, uint8_t *data, const uint8_t length);
+void bootloader_read_eeprom_page(const uint32_t page_num, uint32_t *data);
+void bootloader_write_eeprom_page(const uint32_t page_num, uint32_t *data);
+
+#endif
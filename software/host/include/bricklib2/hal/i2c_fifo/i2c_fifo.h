@@ -0,0 +1,62 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * i2c_fifo.h: Host replacement for the bricklib2 I2C FIFO
+ *             with simulated I2C devices
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef I2C_FIFO_H
+#define I2C_FIFO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "xmc_gpio.h"
+#include "xmc_i2c.h"
+
+#define I2C_FIFO_REG_TYPE uint8_t
+
+typedef struct {
+	uint32_t baudrate;
+	uint8_t address;
+	XMC_USIC_CH_t *i2c;
+
+	XMC_GPIO_PORT_t *scl_port;
+	uint8_t scl_pin;
+	uint32_t scl_mode;
+	uint32_t scl_input;
+	uint32_t scl_source;
+	uint32_t scl_fifo_size;
+	uint32_t scl_fifo_pointer;
+
+	XMC_GPIO_PORT_t *sda_port;
+	uint8_t sda_pin;
+	uint32_t sda_mode;
+	uint32_t sda_input;
+	uint32_t sda_source;
+	uint32_t sda_fifo_size;
+	uint32_t sda_fifo_pointer;
+} I2CFifo;
+
+void i2c_fifo_init(I2CFifo *i2c_fifo);
+uint32_t i2c_fifo_coop_read_register(I2CFifo *i2c_fifo, const I2C_FIFO_REG_TYPE reg, const uint32_t length, uint8_t *data);
+uint32_t i2c_fifo_coop_write_register(I2CFifo *i2c_fifo, const I2C_FIFO_REG_TYPE reg, const uint32_t length, const uint8_t *data, const bool send_stop);
+uint32_t i2c_fifo_coop_read_direct(I2CFifo *i2c_fifo, const uint32_t length, uint8_t *data, const bool restart);
+uint32_t i2c_fifo_coop_write_direct(I2CFifo *i2c_fifo, const uint32_t length, const uint8_t *data, const bool send_stop);
+
+#endif
@@ -0,0 +1,36 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * logging.h: Host replacement for the bricklib2 logging
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#define LOGGING_NONE  0
+#define LOGGING_DEBUG 1
+
+// The simulation runs without log output, it would dominate the runtime.
+// Events of the firmware are available through the trace buffer.
+#define LOGGING_LEVEL LOGGING_NONE
+
+#define logd(...)
+#define logw(...)
+#define loge(...)
+
+#endif
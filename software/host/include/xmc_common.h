@@ -0,0 +1,38 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * xmc_common.h: Host replacement for the CMSIS functions used by the firmware
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef XMC_COMMON_H
+#define XMC_COMMON_H
+
+#include <stdint.h>
+
+// Interrupts are called synchronously by the simulation,
+// so a compiler barrier is sufficient
+#define __DMB() __asm__ volatile("" ::: "memory")
+
+// The simulation does not run the main loop, nothing to wait for
+#define __WFI()
+
+void NVIC_EnableIRQ(const int32_t irq);
+void NVIC_DisableIRQ(const int32_t irq);
+void NVIC_SetPriority(const int32_t irq, const uint32_t priority);
+
+#endif
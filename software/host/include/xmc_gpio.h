@@ -0,0 +1,73 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * xmc_gpio.h: Host replacement for the XMC GPIO driver
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef XMC_GPIO_H
+#define XMC_GPIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "xmc_common.h"
+
+typedef struct {
+	uint8_t port;
+} XMC_GPIO_PORT_t;
+
+extern XMC_GPIO_PORT_t xmc_gpio_port0;
+extern XMC_GPIO_PORT_t xmc_gpio_port2;
+
+#define XMC_GPIO_PORT0 (&xmc_gpio_port0)
+#define XMC_GPIO_PORT2 (&xmc_gpio_port2)
+
+#define P2_1 XMC_GPIO_PORT2, 1
+#define P2_2 XMC_GPIO_PORT2, 2
+#define P2_6 XMC_GPIO_PORT2, 6
+#define P2_7 XMC_GPIO_PORT2, 7
+
+typedef enum {
+	XMC_GPIO_MODE_INPUT_TRISTATE,
+	XMC_GPIO_MODE_INPUT_PULL_UP,
+	XMC_GPIO_MODE_OUTPUT_OPEN_DRAIN,
+	XMC_GPIO_MODE_OUTPUT_OPEN_DRAIN_ALT7
+} XMC_GPIO_MODE_t;
+
+typedef enum {
+	XMC_GPIO_INPUT_HYSTERESIS_STANDARD,
+	XMC_GPIO_INPUT_HYSTERESIS_LARGE
+} XMC_GPIO_INPUT_HYSTERESIS_t;
+
+typedef enum {
+	XMC_GPIO_OUTPUT_LEVEL_LOW,
+	XMC_GPIO_OUTPUT_LEVEL_HIGH
+} XMC_GPIO_OUTPUT_LEVEL_t;
+
+typedef struct {
+	XMC_GPIO_MODE_t mode;
+	XMC_GPIO_INPUT_HYSTERESIS_t input_hysteresis;
+	XMC_GPIO_OUTPUT_LEVEL_t output_level;
+} XMC_GPIO_CONFIG_t;
+
+void XMC_GPIO_Init(XMC_GPIO_PORT_t *const port, const uint8_t pin, const XMC_GPIO_CONFIG_t *const config);
+uint32_t XMC_GPIO_GetInput(XMC_GPIO_PORT_t *const port, const uint8_t pin);
+void XMC_GPIO_SetOutputHigh(XMC_GPIO_PORT_t *const port, const uint8_t pin);
+void XMC_GPIO_SetOutputLow(XMC_GPIO_PORT_t *const port, const uint8_t pin);
+
+#endif
@@ -0,0 +1,41 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * xmc_i2c.h: Host replacement for the XMC I2C driver
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef XMC_I2C_H
+#define XMC_I2C_H
+
+#include <stdint.h>
+
+#include "xmc_usic.h"
+
+extern XMC_USIC_CH_t xmc_i2c0_ch1;
+
+#define XMC_I2C0_CH1 (&xmc_i2c0_ch1)
+
+#define XMC_I2C_CH_EVENT_ACK                      (1 << 0)
+#define XMC_I2C_CH_EVENT_NACK                     (1 << 1)
+#define XMC_I2C_CH_EVENT_STOP_CONDITION_RECEIVED  (1 << 2)
+#define XMC_I2C_CH_EVENT_ARBITRATION_LOST         (1 << 3)
+#define XMC_I2C_CH_EVENT_ERROR                    (1 << 4)
+
+void XMC_I2C_CH_EnableEvent(XMC_USIC_CH_t *const channel, const uint32_t event);
+
+#endif
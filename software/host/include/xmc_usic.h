@@ -0,0 +1,54 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * xmc_usic.h: Host replacement for the XMC USIC driver
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef XMC_USIC_H
+#define XMC_USIC_H
+
+#include <stdint.h>
+
+#include "xmc_common.h"
+
+typedef struct {
+	uint8_t channel;
+} XMC_USIC_CH_t;
+
+#define XMC_USIC_CH_FIFO_SIZE_16WORDS 4
+
+#define XMC_USIC_CH_INPUT_DX0 0
+#define XMC_USIC_CH_INPUT_DX1 1
+
+#define XMC_USIC_CH_RXFIFO_EVENT_CONF_STANDARD  (1 << 0)
+#define XMC_USIC_CH_RXFIFO_EVENT_CONF_ALTERNATE (1 << 1)
+
+typedef enum {
+	XMC_USIC_CH_INTERRUPT_NODE_POINTER_PROTOCOL
+} XMC_USIC_CH_INTERRUPT_NODE_POINTER_t;
+
+typedef enum {
+	XMC_USIC_CH_RXFIFO_INTERRUPT_NODE_POINTER_STANDARD,
+	XMC_USIC_CH_RXFIFO_INTERRUPT_NODE_POINTER_ALTERNATE
+} XMC_USIC_CH_RXFIFO_INTERRUPT_NODE_POINTER_t;
+
+void XMC_USIC_CH_SetInterruptNodePointer(XMC_USIC_CH_t *const channel, const XMC_USIC_CH_INTERRUPT_NODE_POINTER_t interrupt_node, const uint32_t service_request);
+void XMC_USIC_CH_RXFIFO_SetInterruptNodePointer(XMC_USIC_CH_t *const channel, const XMC_USIC_CH_RXFIFO_INTERRUPT_NODE_POINTER_t interrupt_node, const uint32_t service_request);
+void XMC_USIC_CH_RXFIFO_EnableEvent(XMC_USIC_CH_t *const channel, const uint32_t event);
+
+#endif
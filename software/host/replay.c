@@ -0,0 +1,355 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * replay.c: Replays recorded sensor traces through the firmware
+ *           processing code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+
+#include "sim.h"
+
+#include "bricklib2/hal/system_timer/system_timer.h"
+
+#include "communication.h"
+#include "gas.h"
+#include "exposure.h"
+
+// Runs recorded ADC counts, temperatures and humidities through the
+// unchanged firmware code (gas_process_sample and the callback handlers)
+// as fast as possible. The output is bit-for-bit what the Bricklet
+// calculates and sends for the same input.
+//
+// Input (CSV, "#" starts a comment, an optional header line is skipped):
+//   time,adc_count,temperature,humidity
+//   with time in ms, temperature in °C/100 and humidity in %RH/100, both
+//   as measured by the HDC1080 (before the calibrated offsets).
+//
+// Input (binary, --binary): records of 12 bytes, little endian
+//   uint32 time, int32 adc_count, int16 temperature, uint16 humidity
+//
+// Output (CSV on stdout):
+//   time,event,adc_count,temperature,humidity,ppb,slope,twa,stel,limit_exceeded
+//   event "sample" for every input record and "values", "concentration_slope"
+//   and "exposure_limit" for every callback, with the fields of the callback.
+
+typedef struct {
+	uint32_t time;
+	int32_t  adc_count;
+	int16_t  temperature;
+	uint16_t humidity;
+} ReplayRecord;
+
+static bool replay_callbacks_only = false;
+static uint32_t replay_callback_count = 0;
+
+static bool replay_read_record(FILE *file, const bool binary, ReplayRecord *record) {
+	if(binary) {
+		uint8_t data[12];
+		if(fread(data, sizeof(data), 1, file) != 1) {
+			return false;
+		}
+
+		record->time        = data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+		record->adc_count   = (int32_t)(data[4] | (data[5] << 8) | (data[6] << 16) | ((uint32_t)data[7] << 24));
+		record->temperature = (int16_t)(data[8] | (data[9] << 8));
+		record->humidity    = data[10] | (data[11] << 8);
+
+		return true;
+	}
+
+	char line[256];
+	while(fgets(line, sizeof(line), file) != NULL) {
+		long time, adc_count, temperature, humidity;
+		if(sscanf(line, "%ld,%ld,%ld,%ld", &time, &adc_count, &temperature, &humidity) == 4) {
+			record->time        = time;
+			record->adc_count   = adc_count;
+			record->temperature = temperature;
+			record->humidity    = humidity;
+
+			return true;
+		}
+		// Comments, empty lines and the header are skipped
+	}
+
+	return false;
+}
+
+static void replay_message_handler(const uint8_t *data, const uint8_t length) {
+	const uint32_t time = system_timer_get_ms();
+	replay_callback_count++;
+
+	switch(tfp_get_fid_from_message(data)) {
+		case FID_CALLBACK_VALUES: {
+			const Values_Callback *cb = (const Values_Callback*)data;
+			printf("%u,values,,%d,%u,%d,,,,\n", time, cb->temperature, cb->humidity, cb->gas_concentration);
+			break;
+		}
+
+		case FID_CALLBACK_CONCENTRATION_SLOPE: {
+			const ConcentrationSlope_Callback *cb = (const ConcentrationSlope_Callback*)data;
+			printf("%u,concentration_slope,,,,,%d,,,\n", time, cb->slope);
+			break;
+		}
+
+		case FID_CALLBACK_EXPOSURE_LIMIT: {
+			const ExposureLimit_Callback *cb = (const ExposureLimit_Callback*)data;
+			printf("%u,exposure_limit,,,,,,%d,%d,%d\n", time, cb->twa, cb->stel, (cb->twa_exceeded ? EXPOSURE_LIMIT_TWA : 0) | (cb->stel_exceeded ? EXPOSURE_LIMIT_STEL : 0));
+			break;
+		}
+	}
+}
+
+static void replay_request(void *message, const uint8_t length, const uint8_t fid, const char *name) {
+	uint8_t response[80];
+	if(sim_request(message, length, fid, response) == HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER) {
+		fprintf(stderr, "Invalid parameter for %s\n", name);
+		exit(1);
+	}
+}
+
+static void replay_usage(const char *name) {
+	fprintf(stderr,
+		"Usage: %s [options] [trace]\n"
+		"Reads the trace from stdin if no file is given.\n\n"
+		"  -b, --binary                 Trace is binary instead of CSV\n"
+		"  -t, --type TYPE              Gas type (0 = CO, ...)\n"
+		"  -z, --adc-count-zero COUNT   Calibrated ADC count at zero concentration\n"
+		"  -s, --sensitivity VALUE      Calibrated sensitivity in nA/ppm*100\n"
+		"  -T, --temperature-offset T   Calibrated temperature offset in °C/100\n"
+		"  -p, --period MS              Period of the values callback\n"
+		"  -w, --slope-window SIZE      Concentration slope window in samples\n"
+		"  -S, --slope-callback P,V,O,MIN,MAX\n"
+		"                               Concentration slope callback configuration\n"
+		"                               (period, value has to change, option, min, max)\n"
+		"  -l, --exposure-limits TWA,STEL\n"
+		"                               Exposure limits in ppb\n"
+		"  -o, --outlier-filter MODE,WINDOW,THRESHOLD\n"
+		"                               Outlier filter configuration\n"
+		"                               (0 = off, 1 = median, 2 = MAD)\n"
+		"  -B, --baseline-tracking TC,QUIET,LIMIT\n"
+		"                               Enable baseline tracking (time constant in\n"
+		"                               minutes, quiet threshold and limit in ppb)\n"
+		"  -c, --callbacks-only         Only print callbacks\n",
+		name);
+}
+
+int main(int argc, char **argv) {
+	static const struct option options[] = {
+		{"binary",             no_argument,       NULL, 'b'},
+		{"type",               required_argument, NULL, 't'},
+		{"adc-count-zero",     required_argument, NULL, 'z'},
+		{"sensitivity",        required_argument, NULL, 's'},
+		{"temperature-offset", required_argument, NULL, 'T'},
+		{"period",             required_argument, NULL, 'p'},
+		{"slope-window",       required_argument, NULL, 'w'},
+		{"slope-callback",     required_argument, NULL, 'S'},
+		{"exposure-limits",    required_argument, NULL, 'l'},
+		{"outlier-filter",     required_argument, NULL, 'o'},
+		{"baseline-tracking",  required_argument, NULL, 'B'},
+		{"callbacks-only",     no_argument,       NULL, 'c'},
+		{"help",               no_argument,       NULL, 'h'},
+		{NULL, 0, NULL, 0}
+	};
+
+	bool binary = false;
+	SetCalibration calibration = {0};
+	SetValuesCallbackConfiguration values_configuration = {0};
+	SetConcentrationSlopeConfiguration slope_configuration = {0};
+	SetConcentrationSlopeCallbackConfiguration slope_callback_configuration = {0};
+	SetExposureLimitConfiguration exposure_limit_configuration = {0};
+	SetOutlierFilterConfiguration outlier_filter_configuration = {0};
+	SetBaselineTrackingConfiguration baseline_tracking_configuration = {0};
+	bool has_slope_configuration = false;
+	bool has_slope_callback_configuration = false;
+	bool has_exposure_limit_configuration = false;
+	bool has_outlier_filter_configuration = false;
+	bool has_baseline_tracking_configuration = false;
+
+	sim_init();
+	sim.spitfp_fetch_time = 0; // Every callback is fetched immediately
+
+	int option;
+	while((option = getopt_long(argc, argv, "bt:z:s:T:p:w:S:l:o:B:ch", options, NULL)) != -1) {
+		switch(option) {
+			case 'b': binary = true; break;
+			case 't': sim.gas_type = atoi(optarg); break;
+			case 'z': calibration.adc_count_zero = atoi(optarg); break;
+			case 's': calibration.sensitivity = atoi(optarg); break;
+			case 'T': calibration.temperature_offset = atoi(optarg); break;
+			case 'p': values_configuration.period = atoi(optarg); break;
+			case 'w': {
+				slope_configuration.window_size = atoi(optarg);
+				has_slope_configuration = true;
+				break;
+			}
+
+			case 'S': {
+				unsigned int period, value_has_to_change;
+				char threshold_option;
+				int min, max;
+				if(sscanf(optarg, "%u,%u,%c,%d,%d", &period, &value_has_to_change, &threshold_option, &min, &max) != 5) {
+					replay_usage(argv[0]);
+					return 1;
+				}
+
+				slope_callback_configuration.period              = period;
+				slope_callback_configuration.value_has_to_change = value_has_to_change;
+				slope_callback_configuration.option              = threshold_option;
+				slope_callback_configuration.min                 = min;
+				slope_callback_configuration.max                 = max;
+				has_slope_callback_configuration = true;
+				break;
+			}
+
+			case 'l': {
+				unsigned int twa, stel;
+				if(sscanf(optarg, "%u,%u", &twa, &stel) != 2) {
+					replay_usage(argv[0]);
+					return 1;
+				}
+
+				exposure_limit_configuration.twa_limit  = twa;
+				exposure_limit_configuration.stel_limit = stel;
+				has_exposure_limit_configuration = true;
+				break;
+			}
+
+			case 'o': {
+				unsigned int mode, window_size, threshold;
+				if(sscanf(optarg, "%u,%u,%u", &mode, &window_size, &threshold) != 3) {
+					replay_usage(argv[0]);
+					return 1;
+				}
+
+				outlier_filter_configuration.mode        = mode;
+				outlier_filter_configuration.window_size = window_size;
+				outlier_filter_configuration.threshold   = threshold;
+				has_outlier_filter_configuration = true;
+				break;
+			}
+
+			case 'B': {
+				unsigned int time_constant, quiet_threshold, limit;
+				if(sscanf(optarg, "%u,%u,%u", &time_constant, &quiet_threshold, &limit) != 3) {
+					replay_usage(argv[0]);
+					return 1;
+				}
+
+				baseline_tracking_configuration.enable          = true;
+				baseline_tracking_configuration.time_constant   = time_constant;
+				baseline_tracking_configuration.quiet_threshold = quiet_threshold;
+				baseline_tracking_configuration.limit           = limit;
+				has_baseline_tracking_configuration = true;
+				break;
+			}
+
+			case 'c': replay_callbacks_only = true; break;
+			default: replay_usage(argv[0]); return option == 'h' ? 0 : 1;
+		}
+	}
+
+	if(calibration.sensitivity == 0) {
+		fprintf(stderr, "The sensitivity has to be set (--sensitivity)\n");
+		return 1;
+	}
+
+	FILE *file = stdin;
+	if(optind < argc) {
+		file = fopen(argv[optind], binary ? "rb" : "r");
+		if(file == NULL) {
+			perror(argv[optind]);
+			return 1;
+		}
+	}
+
+	ReplayRecord record;
+	if(!replay_read_record(file, binary, &record)) {
+		fprintf(stderr, "Trace is empty\n");
+		return 1;
+	}
+
+	// Start the firmware at the time of the first record. The calibration
+	// and configuration go through the same code as on the Bricklet.
+	sim.time_us = ((uint64_t)record.time)*1000;
+	sim_start();
+
+	replay_request(&calibration, sizeof(calibration), FID_SET_CALIBRATION, "calibration");
+	gas_calibration_write();
+	gas_calibration_read();
+	gas_update_coefficients();
+
+	replay_request(&values_configuration, sizeof(values_configuration), FID_SET_VALUES_CALLBACK_CONFIGURATION, "values callback configuration");
+	if(has_slope_configuration) {
+		replay_request(&slope_configuration, sizeof(slope_configuration), FID_SET_CONCENTRATION_SLOPE_CONFIGURATION, "concentration slope configuration");
+	}
+	if(has_slope_callback_configuration) {
+		replay_request(&slope_callback_configuration, sizeof(slope_callback_configuration), FID_SET_CONCENTRATION_SLOPE_CALLBACK_CONFIGURATION, "concentration slope callback configuration");
+	}
+	if(has_exposure_limit_configuration) {
+		replay_request(&exposure_limit_configuration, sizeof(exposure_limit_configuration), FID_SET_EXPOSURE_LIMIT_CONFIGURATION, "exposure limit configuration");
+	}
+
+	if(has_outlier_filter_configuration) {
+		replay_request(&outlier_filter_configuration, sizeof(outlier_filter_configuration), FID_SET_OUTLIER_FILTER_CONFIGURATION, "outlier filter configuration");
+	}
+
+	if(has_baseline_tracking_configuration) {
+		replay_request(&baseline_tracking_configuration, sizeof(baseline_tracking_configuration), FID_SET_BASELINE_TRACKING_CONFIGURATION, "baseline tracking configuration");
+	}
+
+	sim.message_handler = replay_message_handler;
+
+	printf("time,event,adc_count,temperature,humidity,ppb,slope,twa,stel,limit_exceeded\n");
+
+	const clock_t start = clock();
+	uint32_t record_count = 0;
+	do {
+		// The callback handlers run every ms in between two records,
+		// exactly as often as in the main loop of the Bricklet
+		while(system_timer_get_ms() < record.time) {
+			communication_tick();
+			sim_advance_us(1000);
+		}
+
+		// Same as the HDC1080 tick and the processing in the gas task
+		gas.temperature = record.temperature - gas.temperature_offset;
+		gas.humidity    = record.humidity    - gas.humidity_offset;
+		gas_process_sample(record.adc_count);
+		record_count++;
+
+		if(!replay_callbacks_only) {
+			printf("%u,sample,%d,%d,%u,%.17g,%d,%d,%d,%u\n", record.time, gas.adc_count, gas.temperature, gas.humidity, gas.ppb, gas.slope, exposure.twa, exposure.stel, exposure.limit_exceeded);
+		}
+
+		communication_tick();
+	} while(replay_read_record(file, binary, &record));
+
+	const double seconds = ((double)(clock() - start))/CLOCKS_PER_SEC;
+	fprintf(stderr, "%u records, %u callbacks, %.3f s (%.0f records/s)\n", record_count, replay_callback_count, seconds, seconds > 0 ? record_count/seconds : 0.0);
+
+	if(file != stdin) {
+		fclose(file);
+	}
+
+	return 0;
+}
@@ -0,0 +1,465 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * sim.c: Simulated hardware for host builds of the firmware
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "sim.h"
+
+#include <string.h>
+
+#include "bricklib2/hal/system_timer/system_timer.h"
+#include "bricklib2/hal/i2c_fifo/i2c_fifo.h"
+#include "bricklib2/os/coop_task.h"
+#include "bricklib2/protocols/tfp/tfp.h"
+#include "bricklib2/utility/communication_callback.h"
+
+#include "configs/config_gas.h"
+#include "configs/config_mcp3423.h"
+#include "configs/config_hdc1080.h"
+#include "configs/config_lmp91000.h"
+
+#include "communication.h"
+#include "gas.h"
+#include "mcp3423.h"
+#include "hdc1080.h"
+#include "lmp91000.h"
+
+// The firmware sources are compiled unchanged against this file. It replaces
+// bricklib2 and the XMC peripherals with a virtual clock, a ucontext based
+// coop task and behavioural models of the MCP3423, HDC1080 and LMP91000.
+// Time only advances in sim_advance_us, so every run is deterministic.
+
+#define SIM_UID 0x12345678
+
+// I2C interrupt of the USIC in gas.c
+void IRQ_Hdlr_11(void);
+
+Sim sim;
+BootloaderStatus bootloader_status;
+
+XMC_GPIO_PORT_t xmc_gpio_port0 = {0};
+XMC_GPIO_PORT_t xmc_gpio_port2 = {2};
+XMC_USIC_CH_t xmc_i2c0_ch1 = {1};
+
+static CoopTask *coop_task_current = NULL;
+
+
+// System timer
+
+uint32_t system_timer_get_ms(void) {
+	return sim.time_us/1000;
+}
+
+bool system_timer_is_time_elapsed_ms(const uint32_t start_measurement, const uint32_t time_to_be_elapsed) {
+	return (uint32_t)(system_timer_get_ms() - start_measurement) >= time_to_be_elapsed;
+}
+
+
+// Coop task
+
+static void coop_task_entry(void) {
+	// Task functions do not return
+	coop_task_current->function();
+}
+
+void coop_task_init(CoopTask *task, void (*function)(void)) {
+	task->function = function;
+
+	getcontext(&task->context);
+	task->context.uc_stack.ss_sp   = task->stack;
+	task->context.uc_stack.ss_size = sizeof(task->stack);
+	task->context.uc_link          = &task->context_caller;
+	makecontext(&task->context, coop_task_entry, 0);
+}
+
+void coop_task_tick(CoopTask *task) {
+	coop_task_current = task;
+	swapcontext(&task->context_caller, &task->context);
+	coop_task_current = NULL;
+}
+
+void coop_task_yield(void) {
+	CoopTask *task = coop_task_current;
+	swapcontext(&task->context, &task->context_caller);
+}
+
+void coop_task_sleep_ms(const uint32_t sleep) {
+	const uint32_t start = system_timer_get_ms();
+	while(!system_timer_is_time_elapsed_ms(start, sleep)) {
+		coop_task_yield();
+	}
+}
+
+
+// XMC peripherals
+
+void XMC_GPIO_Init(XMC_GPIO_PORT_t *const port, const uint8_t pin, const XMC_GPIO_CONFIG_t *const config) {}
+void XMC_GPIO_SetOutputHigh(XMC_GPIO_PORT_t *const port, const uint8_t pin) {}
+void XMC_GPIO_SetOutputLow(XMC_GPIO_PORT_t *const port, const uint8_t pin) {}
+
+uint32_t XMC_GPIO_GetInput(XMC_GPIO_PORT_t *const port, const uint8_t pin) {
+	// The gas type pins are low active, the I2C lines are always released
+	if(port == XMC_GPIO_PORT2) {
+		switch(pin) {
+			case 1: return !(sim.gas_type & (1 << 0));
+			case 2: return !(sim.gas_type & (1 << 1));
+			case 6: return !(sim.gas_type & (1 << 2));
+			case 7: return !(sim.gas_type & (1 << 3));
+		}
+	}
+
+	return 1;
+}
+
+void XMC_USIC_CH_SetInterruptNodePointer(XMC_USIC_CH_t *const channel, const XMC_USIC_CH_INTERRUPT_NODE_POINTER_t interrupt_node, const uint32_t service_request) {}
+void XMC_USIC_CH_RXFIFO_SetInterruptNodePointer(XMC_USIC_CH_t *const channel, const XMC_USIC_CH_RXFIFO_INTERRUPT_NODE_POINTER_t interrupt_node, const uint32_t service_request) {}
+void XMC_USIC_CH_RXFIFO_EnableEvent(XMC_USIC_CH_t *const channel, const uint32_t event) {}
+void XMC_I2C_CH_EnableEvent(XMC_USIC_CH_t *const channel, const uint32_t event) {}
+
+void NVIC_EnableIRQ(const int32_t irq) {
+	if(irq == GAS_I2C_IRQ) {
+		sim.i2c_irq_enabled = true;
+	}
+}
+
+void NVIC_DisableIRQ(const int32_t irq) {
+	if(irq == GAS_I2C_IRQ) {
+		sim.i2c_irq_enabled = false;
+	}
+}
+
+void NVIC_SetPriority(const int32_t irq, const uint32_t priority) {}
+
+
+// Bootloader
+
+uint32_t bootloader_get_uid(void) {
+	return SIM_UID;
+}
+
+bool bootloader_spitfp_is_send_possible(SPITFP *st) {
+	return sim.time_us >= sim.spitfp_busy_until;
+}
+
+void bootloader_spitfp_send_ack_and_message(BootloaderStatus *bs, uint8_t *data, const uint8_t length) {
+	sim.spitfp_busy_until = sim.time_us + sim.spitfp_fetch_time;
+
+	if(sim.message_handler != NULL) {
+		sim.message_handler(data, length);
+	}
+}
+
+void bootloader_read_eeprom_page(const uint32_t page_num, uint32_t *data) {
+	memcpy(data, sim.eeprom[page_num], EEPROM_PAGE_SIZE);
+}
+
+void bootloader_write_eeprom_page(const uint32_t page_num, uint32_t *data) {
+	memcpy(sim.eeprom[page_num], data, EEPROM_PAGE_SIZE);
+}
+
+uint8_t tfp_get_fid_from_message(const void *message) {
+	return ((const TFPMessageHeader*)message)->fid;
+}
+
+void tfp_make_default_header(TFPMessageHeader *header, const uint32_t uid, const uint8_t length, const uint8_t fid) {
+	memset(header, 0, sizeof(TFPMessageHeader));
+
+	header->uid                      = uid;
+	header->length                   = length;
+	header->fid                      = fid;
+	header->sequence_num_and_options = 0x08; // Response expected
+}
+
+
+// Callbacks are polled round robin, at most one callback is sent per tick
+
+static bool (*communication_callbacks[])(void) = {COMMUNICATION_CALLBACK_LIST_INIT};
+
+void communication_callback_tick(void) {
+	static uint32_t last_time    = 0;
+	static uint8_t  last_handler = 0;
+
+	if(!system_timer_is_time_elapsed_ms(last_time, COMMUNICATION_CALLBACK_TICK_WAIT_MS)) {
+		return;
+	}
+
+	for(uint8_t i = 0; i < COMMUNICATION_CALLBACK_HANDLER_NUM; i++) {
+		last_handler = (last_handler + 1) % COMMUNICATION_CALLBACK_HANDLER_NUM;
+		if(communication_callbacks[last_handler]()) {
+			last_time = system_timer_get_ms();
+			break;
+		}
+	}
+}
+
+void communication_callback_init(void) {}
+
+
+// I2C devices
+
+static uint32_t sim_mcp3423_conversion_time(void) {
+	switch(sim.mcp3423_configuration & MCP3423_CONF_MSK_SPS4) {
+		case MCP3423_CONF_MSK_SPS4:  return SIM_MCP3423_CONVERSION_TIME;
+		case MCP3423_CONF_MSK_SPS15: return SIM_MCP3423_CONVERSION_TIME/4;
+		case MCP3423_CONF_MSK_SPS60: return SIM_MCP3423_CONVERSION_TIME/16;
+		default:                     return SIM_MCP3423_CONVERSION_TIME/64;
+	}
+}
+
+// Result of a conversion that ends now. The gas channel (CH1 in the
+// configuration register, pins 1/2) returns the ADC count integrated over the
+// conversion as 18 bit value. The inputs of the second channel are tied to
+// GND on the board, it always reads 0V.
+static uint32_t sim_mcp3423_result(void) {
+	if((sim.mcp3423_configuration & MCP3423_CONF_MSK_CH1) == 0) {
+		// The firmware calculates the ADC count as maximum minus raw value
+		return SIM_ADC_18BIT_MAX - sim.mcp3423_integral/SIM_MCP3423_CONVERSION_TIME;
+	}
+
+	return 0;
+}
+
+static void sim_mcp3423_restart(void) {
+	sim.mcp3423_conversion_start = sim.time_us;
+	sim.mcp3423_integral         = 0;
+	sim.mcp3423_ready            = false;
+}
+
+static uint32_t sim_i2c_device_write(const uint8_t address, const uint8_t *data, const uint32_t length) {
+	switch(address) {
+		case MCP3423_I2C_ADDRESS: {
+			if(length > 0) {
+				// In one-shot mode a conversion is only started if RDY is written as 1
+				sim.mcp3423_configuration = data[0];
+				sim.mcp3423_converting    = (data[0] & MCP3423_CONF_MSK_MODE_CONT) || (data[0] & MCP3423_CONF_MSK_RDY1);
+				sim_mcp3423_restart();
+			}
+			return 0;
+		}
+
+		case HDC1080_I2C_ADDRESS: {
+			if((length == 1) && (data[0] == HDC1080_REG_TEMPERATURE)) {
+				// Pointer write to the temperature register triggers a measurement
+				// Rounded up, so the conversion in the firmware returns the input again
+				sim.hdc1080_temperature = ((((int32_t)sim.temperature) + 4000)*(1 << 16) + 16500 - 1)/16500;
+				sim.hdc1080_humidity    = (((uint32_t)sim.humidity)*(1 << 16) + 10000 - 1)/10000;
+			} else if((length == 3) && (data[0] == HDC1080_REG_CONFIGURATION)) {
+				sim.hdc1080_configuration[0] = data[1];
+				sim.hdc1080_configuration[1] = data[2];
+			}
+			return 0;
+		}
+
+		case LMP91000_I2C_ADDRESS: {
+			for(uint32_t i = 1; i < length; i++) {
+				const uint8_t reg = data[0] + i - 1;
+
+				// A bias change starts the charging transient of the cell
+				if(reg == LMP91000_REG_REFCN) {
+					const int8_t bias_old = sim.lmp91000_registers[reg] & LMP91000_REFCN_BIAS_MASK;
+					const int8_t bias_new = data[i] & LMP91000_REFCN_BIAS_MASK;
+					if(bias_new != bias_old) {
+						sim.bias_step_start     = sim.time_us;
+						sim.bias_step_direction = bias_new > bias_old ? 1 : -1;
+					}
+				}
+
+				sim.lmp91000_registers[reg] = data[i];
+			}
+			return 0;
+		}
+	}
+
+	return 1; // NACK
+}
+
+static uint32_t sim_i2c_device_read(const uint8_t address, const int32_t reg, uint8_t *data, const uint32_t length) {
+	memset(data, 0, length);
+
+	switch(address) {
+		case MCP3423_I2C_ADDRESS: {
+			const uint32_t raw           = sim.mcp3423_result;
+			const uint8_t  configuration = (sim.mcp3423_configuration & ~MCP3423_CONF_MSK_RDY1) | (sim.mcp3423_ready ? 0 : MCP3423_CONF_MSK_RDY1);
+			uint8_t result[4] = {(raw >> 16) & 0x03, (raw >> 8) & 0xFF, (raw >> 0) & 0xFF, configuration};
+
+			// Below 18 bit there are two data bytes, the configuration is repeated
+			if((sim.mcp3423_configuration & MCP3423_CONF_MSK_SPS4) != MCP3423_CONF_MSK_SPS4) {
+				result[0] = (raw >> 8) & 0xFF;
+				result[1] = (raw >> 0) & 0xFF;
+				result[2] = configuration;
+			}
+
+			memcpy(data, result, length < 4 ? length : 4);
+			sim.mcp3423_ready = false;
+			return 0;
+		}
+
+		case HDC1080_I2C_ADDRESS: {
+			uint8_t result[4] = {
+				(sim.hdc1080_temperature >> 8) & 0xFF,
+				(sim.hdc1080_temperature >> 0) & 0xFF,
+				(sim.hdc1080_humidity    >> 8) & 0xFF,
+				(sim.hdc1080_humidity    >> 0) & 0xFF
+			};
+			memcpy(data, result, length < 4 ? length : 4);
+			return 0;
+		}
+
+		case LMP91000_I2C_ADDRESS: {
+			for(uint32_t i = 0; (reg >= 0) && (i < length); i++) {
+				data[i] = sim.lmp91000_registers[(uint8_t)(reg + i)];
+			}
+			return 0;
+		}
+	}
+
+	return 1; // NACK
+}
+
+// The transfer runs in the background while the task yields,
+// the USIC interrupt fires once per byte (see sim_advance_us)
+static void sim_i2c_transfer(const uint32_t bytes) {
+	sim.i2c_transfer_end = sim.time_us + bytes*sim.i2c_byte_time;
+	sim.i2c_next_irq     = sim.time_us + sim.i2c_byte_time;
+
+	while(sim.i2c_stuck || (sim.time_us < sim.i2c_transfer_end)) {
+		coop_task_yield();
+	}
+}
+
+void i2c_fifo_init(I2CFifo *i2c_fifo) {}
+
+uint32_t i2c_fifo_coop_read_register(I2CFifo *i2c_fifo, const I2C_FIFO_REG_TYPE reg, const uint32_t length, uint8_t *data) {
+	sim_i2c_transfer(3 + length);
+	return sim_i2c_device_read(i2c_fifo->address, reg, data, length);
+}
+
+uint32_t i2c_fifo_coop_write_register(I2CFifo *i2c_fifo, const I2C_FIFO_REG_TYPE reg, const uint32_t length, const uint8_t *data, const bool send_stop) {
+	uint8_t buffer[1 + 256];
+	buffer[0] = reg;
+	memcpy(&buffer[1], data, length);
+
+	sim_i2c_transfer(2 + length);
+	return sim_i2c_device_write(i2c_fifo->address, buffer, 1 + length);
+}
+
+uint32_t i2c_fifo_coop_read_direct(I2CFifo *i2c_fifo, const uint32_t length, uint8_t *data, const bool restart) {
+	sim_i2c_transfer(1 + length);
+	return sim_i2c_device_read(i2c_fifo->address, -1, data, length);
+}
+
+uint32_t i2c_fifo_coop_write_direct(I2CFifo *i2c_fifo, const uint32_t length, const uint8_t *data, const bool send_stop) {
+	sim_i2c_transfer(1 + length);
+	return sim_i2c_device_write(i2c_fifo->address, data, length);
+}
+
+
+// Simulation
+
+void sim_advance_us(const uint32_t us) {
+	const uint64_t end = sim.time_us + us;
+
+	// The MCP3423 integrates the input over the whole conversion
+	int32_t adc_count = sim.adc_count;
+	if((sim.bias_step_direction != 0) && (sim.time_us - sim.bias_step_start < SIM_BIAS_STEP_TRANSIENT_TIME)) {
+		adc_count += sim.bias_step_direction*sim.bias_step_response;
+	}
+	if(adc_count < 0) {
+		adc_count = 0;
+	} else if(adc_count > SIM_ADC_18BIT_MAX) {
+		adc_count = SIM_ADC_18BIT_MAX;
+	}
+
+	while(sim.time_us < end) {
+		if(!sim.mcp3423_converting) {
+			// Standby in one-shot mode
+			sim.time_us = end;
+			break;
+		}
+
+		const uint32_t conversion_time = sim_mcp3423_conversion_time();
+		const uint64_t conversion_end  = sim.mcp3423_conversion_start + conversion_time;
+		const uint64_t step_end        = conversion_end < end ? conversion_end : end;
+
+		sim.mcp3423_integral += ((int64_t)adc_count)*(step_end - sim.time_us);
+		sim.time_us           = step_end;
+
+		if(sim.time_us == conversion_end) {
+			sim.mcp3423_result           = sim_mcp3423_result();
+			sim.mcp3423_ready            = true;
+			sim.mcp3423_integral         = 0;
+			sim.mcp3423_conversion_start = conversion_end;
+			sim.mcp3423_conversion_count++;
+
+			if(!(sim.mcp3423_configuration & MCP3423_CONF_MSK_MODE_CONT)) {
+				sim.mcp3423_converting = false;
+			}
+		}
+	}
+
+	while((sim.i2c_next_irq != 0) && (sim.i2c_next_irq <= sim.time_us)) {
+		if(sim.i2c_irq_enabled) {
+			IRQ_Hdlr_11();
+		}
+
+		sim.i2c_next_irq += sim.i2c_byte_time;
+		if(sim.i2c_next_irq > sim.i2c_transfer_end) {
+			sim.i2c_next_irq = 0;
+		}
+	}
+}
+
+void sim_loop(void) {
+	communication_tick();
+	gas_tick();
+	sim_advance_us(sim.loop_time);
+}
+
+void sim_run_until_ms(const uint32_t time) {
+	while(system_timer_get_ms() < time) {
+		sim_loop();
+	}
+}
+
+BootloaderHandleMessageResponse sim_request(void *message, const uint8_t length, const uint8_t fid, void *response) {
+	tfp_make_default_header(message, SIM_UID, length, fid);
+	return handle_message(message, response);
+}
+
+void sim_init(void) {
+	memset(&sim, 0, sizeof(Sim));
+	memset(&bootloader_status, 0, sizeof(BootloaderStatus));
+
+	sim.loop_time          = SIM_DEFAULT_LOOP_TIME;
+	sim.i2c_byte_time      = SIM_DEFAULT_I2C_BYTE_TIME;
+	sim.spitfp_fetch_time  = SIM_DEFAULT_SPITFP_FETCH_TIME;
+	sim.temperature        = 2500;
+	sim.humidity           = 5000;
+	sim.bias_step_response = 2000;
+
+	// Power-on default of the MCP3423 is continuous conversion
+	sim.mcp3423_configuration = MCP3423_CONF_MSK_RDY1 | MCP3423_CONF_MSK_MODE_CONT;
+	sim.mcp3423_converting    = true;
+}
+
+// Same order as in main.c
+void sim_start(void) {
+	communication_init();
+	gas_init();
+}
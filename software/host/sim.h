@@ -0,0 +1,93 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * sim.h: Simulated hardware for host builds of the firmware
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bricklib2/bootloader/bootloader.h"
+
+#define SIM_ADC_18BIT_MAX               262143
+#define SIM_MCP3423_CONVERSION_TIME     266667 // in us, 3.75 SPS in 18 bit mode
+#define SIM_BIAS_STEP_TRANSIENT_TIME    300000 // in us
+
+#define SIM_DEFAULT_LOOP_TIME           20     // in us
+#define SIM_DEFAULT_I2C_BYTE_TIME       90     // in us, 9 bit at 100kHz
+#define SIM_DEFAULT_SPITFP_FETCH_TIME   1000   // in us
+
+typedef void (*SimMessageHandler)(const uint8_t *data, const uint8_t length);
+
+typedef struct {
+	// Virtual time, system_timer_get_ms returns time_us/1000
+	uint64_t time_us;
+
+	// Timing model
+	uint32_t loop_time;         // Duration of one main loop pass in us
+	uint32_t i2c_byte_time;     // Duration of one I2C byte in us
+	uint32_t spitfp_fetch_time; // Time until the Brick fetched a message in us, 0 = immediately
+
+	// Sensor inputs, set by the simulation tool
+	uint8_t  gas_type;
+	int32_t  adc_count;   // ADC count as calculated by the firmware
+	int16_t  temperature; // in °C/100 before the temperature offset
+	uint16_t humidity;    // in %RH/100 before the humidity offset
+	int32_t  bias_step_response; // in ADC counts while the cell is charged after a bias step, 0 = open cell
+
+	// Called for every message that the firmware sends to the Brick
+	SimMessageHandler message_handler;
+
+	// Simulated hardware
+	uint32_t eeprom[EEPROM_PAGE_NUM][EEPROM_PAGE_SIZE/sizeof(uint32_t)];
+	uint64_t spitfp_busy_until;
+	bool     i2c_irq_enabled;
+	bool     i2c_stuck; // Transfers do not finish, like a USIC that lost an event
+	uint64_t i2c_transfer_end;
+	uint64_t i2c_next_irq;
+
+	uint64_t mcp3423_conversion_start;
+	int64_t  mcp3423_integral; // ADC count times us since conversion start
+	uint32_t mcp3423_result;
+	bool     mcp3423_ready;
+	bool     mcp3423_converting; // Always in continuous mode, until the end of the conversion in one-shot mode
+	uint32_t mcp3423_conversion_count;
+	uint8_t  mcp3423_configuration;
+
+	int32_t  hdc1080_temperature;
+	uint32_t hdc1080_humidity;
+	uint8_t  hdc1080_configuration[2];
+
+	uint8_t  lmp91000_registers[256];
+	uint64_t bias_step_start;
+	int8_t   bias_step_direction;
+} Sim;
+
+extern Sim sim;
+
+void sim_init(void);
+void sim_start(void);
+void sim_advance_us(const uint32_t us);
+void sim_loop(void);
+void sim_run_until_ms(const uint32_t time);
+BootloaderHandleMessageResponse sim_request(void *message, const uint8_t length, const uint8_t fid, void *response);
+
+#endif
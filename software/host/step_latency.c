@@ -0,0 +1,314 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * step_latency.c: Step response latency benchmark on the simulated
+ *                 Bricklet
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "sim.h"
+
+#include "communication.h"
+#include "gas.h"
+#include "mcp3423.h"
+
+// Measures the time from a concentration step at the sensor input to the
+// first callback that notifies the host about it. The full firmware runs
+// in the simulation: MCP3423 conversion and polling, the gas task, the
+// callback handlers and the SPITFP transfer to the Brick.
+//
+// The steps alternate between two ADC counts. The time between two steps
+// is pseudo-random with us resolution, so the steps hit every phase of the
+// ADC conversion, the ADC polling and the callback period. Every callback
+// configuration runs in its own process, so the static state of the
+// callback handlers does not leak between configurations.
+//
+// For the values callback the expected worst case is checked: The step has
+// to cover half of a conversion (1.5 conversions), the result waits for the
+// next poll (MCP3423_TIME_BETWEEN_MEASUREMENTS), then for the callback
+// period and the SPITFP transfer. In low power mode the step waits for the
+// next wake up (one interval) and one complete one-shot conversion instead.
+// The program exits with 1 if a maximum latency is above this bound.
+//
+// Hold, settle and timeout are extended by the low power interval.
+
+#define LATENCY_STEPS_DEFAULT   200
+#define LATENCY_STEP_LOW        10000 // in ADC counts
+#define LATENCY_STEP_HIGH       12000 // in ADC counts
+#define LATENCY_HOLD_MIN        2000  // in ms
+#define LATENCY_HOLD_RANDOM     2000  // in ms
+#define LATENCY_TIMEOUT         5000  // in ms
+#define LATENCY_SETTLE_TIME     3000  // in ms
+#define LATENCY_BOUND_SLACK     10    // in ms, I2C transfers and main loop
+
+typedef enum {
+	LATENCY_SOURCE_VALUES,
+	LATENCY_SOURCE_SLOPE
+} LatencySource;
+
+typedef struct {
+	const char *name;
+	LatencySource source;
+	uint32_t period;            // in ms
+	char     option;            // Threshold option of the slope callback
+	int32_t  min;
+	int32_t  max;
+	uint32_t spitfp_fetch_time; // in us
+	uint32_t low_power_interval; // in ms, 0 = continuous measurement
+} LatencyConfiguration;
+
+static const LatencyConfiguration latency_configurations[] = {
+	{"values, period 1ms",                 LATENCY_SOURCE_VALUES,    1, 'x',    0,   0,  1000,    0},
+	{"values, period 10ms",                LATENCY_SOURCE_VALUES,   10, 'x',    0,   0,  1000,    0},
+	{"values, period 100ms",               LATENCY_SOURCE_VALUES,  100, 'x',    0,   0,  1000,    0},
+	{"values, period 250ms",               LATENCY_SOURCE_VALUES,  250, 'x',    0,   0,  1000,    0},
+	{"values, period 1000ms",              LATENCY_SOURCE_VALUES, 1000, 'x',    0,   0,  1000,    0},
+	{"values, period 1ms, slow Brick",     LATENCY_SOURCE_VALUES,    1, 'x',    0,   0, 10000,    0},
+	{"values, period 1ms, low power 1s",   LATENCY_SOURCE_VALUES,    1, 'x',    0,   0,  1000, 1000},
+	{"values, period 1ms, low power 5s",   LATENCY_SOURCE_VALUES,    1, 'x',    0,   0,  1000, 5000},
+	{"slope, period 1ms, outside +-1ppm",  LATENCY_SOURCE_SLOPE,     1, 'o', -1000, 1000, 1000,    0},
+	{"slope, period 100ms, outside +-1ppm",LATENCY_SOURCE_SLOPE,   100, 'o', -1000, 1000, 1000,    0},
+};
+
+#define LATENCY_CONFIGURATION_NUM (sizeof(latency_configurations)/sizeof(LatencyConfiguration))
+
+typedef struct {
+	const LatencyConfiguration *configuration;
+
+	bool     waiting;
+	int8_t   direction;
+	int32_t  threshold; // in ppb, half way between the two concentrations
+	uint64_t step_time; // in us
+	uint64_t detect_time;
+} Latency;
+
+static Latency latency;
+
+static uint32_t latency_random_state = 1;
+
+static uint32_t latency_random(void) {
+	// Deterministic, so a run is reproducible
+	latency_random_state = latency_random_state*1103515245 + 12345;
+	return latency_random_state >> 8;
+}
+
+static void latency_message_handler(const uint8_t *data, const uint8_t length) {
+	if(!latency.waiting) {
+		return;
+	}
+
+	bool detected = false;
+	switch(tfp_get_fid_from_message(data)) {
+		case FID_CALLBACK_VALUES: {
+			const Values_Callback *cb = (const Values_Callback*)data;
+			detected = (latency.configuration->source == LATENCY_SOURCE_VALUES) && (latency.direction*(cb->gas_concentration - latency.threshold) >= 0);
+			break;
+		}
+
+		case FID_CALLBACK_CONCENTRATION_SLOPE: {
+			const ConcentrationSlope_Callback *cb = (const ConcentrationSlope_Callback*)data;
+			detected = (latency.configuration->source == LATENCY_SOURCE_SLOPE) && (latency.direction*cb->slope > 0);
+			break;
+		}
+	}
+
+	if(detected) {
+		latency.waiting     = false;
+		latency.detect_time = sim.time_us;
+	}
+}
+
+static uint32_t latency_extra_time = 0; // in ms, added to hold, settle and timeout in low power mode
+
+static void latency_run_us(const uint64_t time) {
+	while(sim.time_us < time) {
+		sim_loop();
+	}
+}
+
+static int32_t latency_settle(const int32_t adc_count) {
+	sim.adc_count = adc_count;
+	latency_run_us(sim.time_us + (LATENCY_SETTLE_TIME + latency_extra_time)*1000ULL);
+
+	GasSnapshot snapshot;
+	gas_snapshot_read(&snapshot);
+
+	return snapshot.ppb;
+}
+
+static int compare_uint32(const void *a, const void *b) {
+	const uint32_t x = *(const uint32_t*)a;
+	const uint32_t y = *(const uint32_t*)b;
+
+	return (x > y) - (x < y);
+}
+
+static uint32_t latency_bound(const LatencyConfiguration *configuration) {
+	if(configuration->source != LATENCY_SOURCE_VALUES) {
+		return 0;
+	}
+
+	if(configuration->low_power_interval != 0) {
+		return configuration->low_power_interval + SIM_MCP3423_CONVERSION_TIME/1000 + MCP3423_ONE_SHOT_POLL_TIME + configuration->period + configuration->spitfp_fetch_time/1000 + LATENCY_BOUND_SLACK;
+	}
+
+	return SIM_MCP3423_CONVERSION_TIME*3/2/1000 + MCP3423_TIME_BETWEEN_MEASUREMENTS + configuration->period + configuration->spitfp_fetch_time/1000 + LATENCY_BOUND_SLACK;
+}
+
+// Returns true if the latency is within the expected bound
+static bool latency_benchmark(const LatencyConfiguration *configuration, const uint32_t steps) {
+	sim_init();
+	sim.spitfp_fetch_time = configuration->spitfp_fetch_time;
+	sim_start();
+
+	SetCalibration calibration = {0};
+	calibration.sensitivity    = 475; // nA/ppm*100
+	uint8_t response[80];
+	sim_request(&calibration, sizeof(calibration), FID_SET_CALIBRATION, response);
+
+	// The sample hold during a diagnostic run would add up to 2.5s to a step
+	SetDiagnosticConfiguration diagnostic = {0};
+	sim_request(&diagnostic, sizeof(diagnostic), FID_SET_DIAGNOSTIC_CONFIGURATION, response);
+
+	if(configuration->low_power_interval != 0) {
+		SetLowPowerConfiguration low_power = {0};
+		low_power.enable   = true;
+		low_power.interval = configuration->low_power_interval;
+		sim_request(&low_power, sizeof(low_power), FID_SET_LOW_POWER_CONFIGURATION, response);
+		latency_extra_time = 2*configuration->low_power_interval;
+	}
+
+	const int32_t ppb_low  = latency_settle(LATENCY_STEP_LOW);
+	const int32_t ppb_high = latency_settle(LATENCY_STEP_HIGH);
+
+	latency.configuration = configuration;
+	latency.threshold     = (ppb_low + ppb_high)/2;
+	sim.message_handler   = latency_message_handler;
+
+	if(configuration->source == LATENCY_SOURCE_VALUES) {
+		SetValuesCallbackConfiguration values = {0};
+		values.period = configuration->period;
+		sim_request(&values, sizeof(values), FID_SET_VALUES_CALLBACK_CONFIGURATION, response);
+	} else {
+		SetConcentrationSlopeCallbackConfiguration slope = {0};
+		slope.period              = configuration->period;
+		slope.value_has_to_change = true;
+		slope.option              = configuration->option;
+		slope.min                 = configuration->min;
+		slope.max                 = configuration->max;
+		sim_request(&slope, sizeof(slope), FID_SET_CONCENTRATION_SLOPE_CALLBACK_CONFIGURATION, response);
+	}
+
+	uint32_t *latencies = malloc(steps*sizeof(uint32_t));
+	uint32_t timeouts   = 0;
+	for(uint32_t i = 0; i < steps; i++) {
+		latency_run_us(sim.time_us + (LATENCY_HOLD_MIN + latency_extra_time)*1000ULL + latency_random() % ((LATENCY_HOLD_RANDOM + latency_extra_time)*1000));
+
+		latency.direction = sim.adc_count == LATENCY_STEP_LOW ? 1 : -1;
+		latency.step_time = sim.time_us;
+		latency.waiting   = true;
+		sim.adc_count     = sim.adc_count == LATENCY_STEP_LOW ? LATENCY_STEP_HIGH : LATENCY_STEP_LOW;
+
+		while(latency.waiting && (sim.time_us - latency.step_time < (LATENCY_TIMEOUT + latency_extra_time)*1000ULL)) {
+			sim_loop();
+		}
+
+		if(latency.waiting) {
+			latency.waiting = false;
+			latencies[i]    = (LATENCY_TIMEOUT + latency_extra_time)*1000;
+			timeouts++;
+		} else {
+			latencies[i]    = latency.detect_time - latency.step_time;
+		}
+	}
+
+	qsort(latencies, steps, sizeof(uint32_t), compare_uint32);
+
+	const uint32_t bound = latency_bound(configuration);
+	const bool ok        = (timeouts == 0) && ((bound == 0) || (latencies[steps - 1] <= bound*1000));
+
+	char bound_text[16] = "-";
+	if(bound != 0) {
+		snprintf(bound_text, sizeof(bound_text), "%u", bound);
+	}
+
+	printf("%-38s %6u %8.1f %8.1f %8.1f %8.1f %8s %s\n",
+	       configuration->name,
+	       steps,
+	       latencies[0]/1000.0,
+	       latencies[steps/2]/1000.0,
+	       latencies[(steps*99)/100]/1000.0,
+	       latencies[steps - 1]/1000.0,
+	       bound_text,
+	       ok ? "ok" : (timeouts > 0 ? "TIMEOUT" : "FAIL"));
+
+	free(latencies);
+	return ok;
+}
+
+int main(int argc, char **argv) {
+	uint32_t steps = LATENCY_STEPS_DEFAULT;
+
+	int option;
+	while((option = getopt(argc, argv, "n:h")) != -1) {
+		switch(option) {
+			case 'n': steps = atoi(optarg); break;
+			default: {
+				fprintf(stderr, "Usage: %s [-n steps]\n", argv[0]);
+				return option == 'h' ? 0 : 1;
+			}
+		}
+	}
+
+	if(steps == 0) {
+		return 1;
+	}
+
+	printf("%-38s %6s %8s %8s %8s %8s %8s\n", "configuration (latency in ms)", "steps", "min", "p50", "p99", "max", "bound");
+	fflush(stdout);
+
+	bool ok = true;
+	for(uint32_t i = 0; i < LATENCY_CONFIGURATION_NUM; i++) {
+		const pid_t pid = fork();
+		if(pid < 0) {
+			perror("fork");
+			return 1;
+		}
+
+		if(pid == 0) {
+			const bool child_ok = latency_benchmark(&latency_configurations[i], steps);
+			fflush(stdout);
+			_exit(child_ok ? 0 : 1);
+		}
+
+		int status = 0;
+		if(waitpid(pid, &status, 0) != pid) {
+			perror("waitpid");
+			return 1;
+		}
+
+		ok = ok && WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+	}
+
+	return ok ? 0 : 1;
+}
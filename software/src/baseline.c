@@ -0,0 +1,133 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * baseline.c: Automatic baseline (zero) drift tracking
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "baseline.h"
+
+#include <string.h>
+
+#include "trace.h"
+
+// The zero of an electrochemical cell drifts over weeks. The baseline
+// tracker learns the drift from quiet periods and moves the calibrated
+// zero accordingly.
+//
+// The samples are collected in blocks of one minute. A block is quiet if
+// all samples are within the quiet threshold, blocks with changing gas
+// concentration are ignored. The mean of a quiet block is the candidate for
+// the zero. Since gas can only increase the concentration, a candidate below
+// the current baseline is followed quickly and a candidate above it only
+// with the (slow) time constant. This is a minimum tracker that does not
+// learn a constant gas concentration as zero unless it persists for several
+// time constants. The offset is clamped to the limit.
+
+Baseline baseline;
+
+// Clamps the offset to the limit, which is given in ppb
+void baseline_clamp(const double ppb_per_count) {
+	const double ppb_per_count_abs = ppb_per_count < 0 ? -ppb_per_count : ppb_per_count;
+	if(ppb_per_count_abs == 0) {
+		return;
+	}
+
+	const double limit = baseline.limit/ppb_per_count_abs;
+	if(baseline.offset > limit) {
+		baseline.offset = limit;
+	} else if(baseline.offset < -limit) {
+		baseline.offset = -limit;
+	}
+}
+
+static void baseline_block_end(const double ppb_per_count) {
+	const double ppb_per_count_abs = ppb_per_count < 0 ? -ppb_per_count : ppb_per_count;
+	if(ppb_per_count_abs == 0) {
+		return;
+	}
+
+	if((baseline.block_max - baseline.block_min)*ppb_per_count_abs > baseline.quiet_threshold) {
+		return;
+	}
+
+	baseline.quiet_blocks++;
+
+	// Direction in ppb, negative if the candidate is below the baseline
+	const double candidate  = ((double)baseline.block_sum)/baseline.block_count;
+	const double difference = candidate - baseline.offset;
+	if(difference*ppb_per_count < 0) {
+		baseline.offset += difference/BASELINE_FALL_TIME_CONSTANT;
+	} else {
+		baseline.offset += difference/baseline.time_constant;
+	}
+
+	baseline_clamp(ppb_per_count);
+
+	trace(TRACE_EVENT_BASELINE, (int32_t)(candidate*256), (int32_t)(baseline.offset*256));
+}
+
+void baseline_add_sample(const int32_t adc_count_relative, const double ppb_per_count, const uint32_t sample_period) {
+	if(!baseline.enable) {
+		return;
+	}
+
+	if(baseline.block_count == 0) {
+		baseline.block_min = adc_count_relative;
+		baseline.block_max = adc_count_relative;
+		baseline.block_sum = 0;
+	} else if(adc_count_relative < baseline.block_min) {
+		baseline.block_min = adc_count_relative;
+	} else if(adc_count_relative > baseline.block_max) {
+		baseline.block_max = adc_count_relative;
+	}
+
+	baseline.block_sum += adc_count_relative;
+	baseline.block_count++;
+
+	// In low power mode a block may consist of a single sample
+	if(baseline.block_count*sample_period >= BASELINE_BLOCK_TIME) {
+		baseline_block_end(ppb_per_count);
+		baseline.block_count = 0;
+	}
+}
+
+void baseline_set_configuration(const bool enable, const uint16_t time_constant, const uint32_t quiet_threshold, const uint32_t limit) {
+	if(!enable) {
+		baseline_reset();
+	}
+
+	baseline.enable          = enable;
+	baseline.time_constant   = time_constant;
+	baseline.quiet_threshold = quiet_threshold;
+	baseline.limit           = limit;
+}
+
+// Has to be called if the zero is calibrated again
+void baseline_reset(void) {
+	baseline.block_count  = 0;
+	baseline.offset       = 0;
+	baseline.quiet_blocks = 0;
+}
+
+void baseline_init(void) {
+	memset(&baseline, 0, sizeof(Baseline));
+	baseline.enable          = false;
+	baseline.time_constant   = BASELINE_TIME_CONSTANT_DEFAULT;
+	baseline.quiet_threshold = BASELINE_QUIET_THRESHOLD_DEFAULT;
+	baseline.limit           = BASELINE_LIMIT_DEFAULT;
+}
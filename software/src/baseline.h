@@ -0,0 +1,59 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * baseline.h: Automatic baseline (zero) drift tracking
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef BASELINE_H
+#define BASELINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BASELINE_BLOCK_TIME                60000 // in ms
+#define BASELINE_FALL_TIME_CONSTANT        4     // in blocks
+#define BASELINE_TIME_CONSTANT_MIN         10    // in minutes
+#define BASELINE_TIME_CONSTANT_DEFAULT     1440  // in minutes
+#define BASELINE_QUIET_THRESHOLD_DEFAULT   100   // in ppb
+#define BASELINE_LIMIT_DEFAULT             5000  // in ppb
+
+typedef struct {
+	bool     enable;
+	uint16_t time_constant;   // in minutes
+	uint32_t quiet_threshold; // in ppb, max. difference of the samples of a quiet block
+	uint32_t limit;           // in ppb, max. offset in both directions
+
+	// Current block, ADC count relative to calibrated zero
+	uint16_t block_count;
+	int32_t  block_min;
+	int32_t  block_max;
+	int64_t  block_sum;
+
+	double   offset; // in ADC counts, relative to calibrated zero
+	uint32_t quiet_blocks;
+} Baseline;
+
+extern Baseline baseline;
+
+void baseline_add_sample(const int32_t adc_count_relative, const double ppb_per_count, const uint32_t sample_period);
+void baseline_clamp(const double ppb_per_count);
+void baseline_set_configuration(const bool enable, const uint16_t time_constant, const uint32_t quiet_threshold, const uint32_t limit);
+void baseline_reset(void);
+void baseline_init(void);
+
+#endif
@@ -0,0 +1,112 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * capture.c: On-device averaging of calibration points
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "capture.h"
+
+#include <string.h>
+
+// A calibration point (zero or span gas) is the mean ADC count over a number
+// of samples. Averaging on the Bricklet needs one request per capture instead
+// of one per sample, so many units can be calibrated in parallel over one
+// connection. The mean and the variance are updated per sample with
+// Welford's algorithm, which stays exact for long captures of large counts.
+// Temperature and humidity are averaged as well, the calibration stores
+// them together with the zero and span counts.
+
+Capture capture;
+
+// Integer square root, rounded down
+static uint32_t capture_isqrt(uint64_t value) {
+	uint64_t root = 0;
+	uint64_t bit  = 1ULL << 62;
+
+	while(bit > value) {
+		bit >>= 2;
+	}
+
+	while(bit != 0) {
+		if(value >= root + bit) {
+			value -= root + bit;
+			root   = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+
+	return root;
+}
+
+// Sample standard deviation in 1/100 ADC counts
+uint32_t capture_get_std_dev(void) {
+	if(capture.count < 2) {
+		return 0;
+	}
+
+	const double variance = capture.m2/(capture.count - 1)*10000.0;
+	if(variance >= (double)UINT64_MAX) {
+		return UINT32_MAX;
+	}
+
+	return capture_isqrt((uint64_t)variance);
+}
+
+int16_t capture_get_temperature(void) {
+	if(capture.count == 0) {
+		return 0;
+	}
+
+	return capture.temperature_sum/capture.count;
+}
+
+uint16_t capture_get_humidity(void) {
+	if(capture.count == 0) {
+		return 0;
+	}
+
+	return capture.humidity_sum/capture.count;
+}
+
+void capture_add_sample(const int32_t adc_count, const int16_t temperature, const uint16_t humidity) {
+	if(capture.state != CAPTURE_STATE_RUNNING) {
+		return;
+	}
+
+	capture.count++;
+
+	const double delta = adc_count - capture.mean;
+	capture.mean += delta/capture.count;
+	capture.m2   += delta*(adc_count - capture.mean);
+
+	capture.temperature_sum += temperature;
+	capture.humidity_sum    += humidity;
+
+	if(capture.count >= capture.samples) {
+		capture.state = CAPTURE_STATE_DONE;
+	}
+}
+
+// Starts a new capture, a running capture is discarded
+void capture_start(const uint16_t samples) {
+	memset(&capture, 0, sizeof(Capture));
+	capture.samples = samples;
+	capture.state   = CAPTURE_STATE_RUNNING;
+}
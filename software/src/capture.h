@@ -0,0 +1,56 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * capture.h: On-device averaging of calibration points
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CAPTURE_SAMPLES_MIN 2
+#define CAPTURE_SAMPLES_MAX 14400 // One hour with 4 SPS
+
+#define CAPTURE_STATE_IDLE    0
+#define CAPTURE_STATE_RUNNING 1
+#define CAPTURE_STATE_DONE    2
+
+typedef struct {
+	uint8_t  state;
+	uint16_t samples; // Number of samples to average
+	uint16_t count;
+
+	// Running mean and sum of squared deviations (Welford)
+	double   mean;    // in ADC counts
+	double   m2;
+
+	int32_t  temperature_sum;
+	int32_t  humidity_sum;
+} Capture;
+
+extern Capture capture;
+
+void capture_start(const uint16_t samples);
+void capture_add_sample(const int32_t adc_count, const int16_t temperature, const uint16_t humidity);
+uint32_t capture_get_std_dev(void);
+int16_t capture_get_temperature(void);
+uint16_t capture_get_humidity(void);
+
+#endif
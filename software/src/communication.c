@@ -21,11 +21,40 @@
 
 #include "communication.h"
 
+#include <string.h>
+
 #include "bricklib2/hal/system_timer/system_timer.h"
 #include "bricklib2/utility/communication_callback.h"
 #include "bricklib2/protocols/tfp/tfp.h"
 
 #include "gas.h"
+#include "exposure.h"
+#include "slope.h"
+#include "outlier.h"
+#include "baseline.h"
+#include "capture.h"
+#include "diagnostic.h"
+#include "trace.h"
+#include "lmp91000.h"
+
+bool is_threshold_option_valid(const char option) {
+	return option == GAS_THRESHOLD_OPTION_OFF ||
+	       option == GAS_THRESHOLD_OPTION_OUTSIDE ||
+	       option == GAS_THRESHOLD_OPTION_INSIDE ||
+	       option == GAS_THRESHOLD_OPTION_SMALLER ||
+	       option == GAS_THRESHOLD_OPTION_GREATER;
+}
+
+static bool is_threshold_met(const char option, const int32_t value, const int32_t min, const int32_t max) {
+	switch(option) {
+		case GAS_THRESHOLD_OPTION_OFF:     return true;
+		case GAS_THRESHOLD_OPTION_OUTSIDE: return value < min || value > max;
+		case GAS_THRESHOLD_OPTION_INSIDE:  return value >= min && value <= max;
+		case GAS_THRESHOLD_OPTION_SMALLER: return value < min;
+		case GAS_THRESHOLD_OPTION_GREATER: return value > min;
+		default:                           return false;
+	}
+}
 
 BootloaderHandleMessageResponse handle_message(const void *message, void *response) {
 	switch(tfp_get_fid_from_message(message)) {
@@ -35,24 +64,63 @@ BootloaderHandleMessageResponse handle_message(const void *message, void *respon
 		case FID_GET_CALIBRATION: return get_calibration(message, response);
 		case FID_SET_VALUES_CALLBACK_CONFIGURATION: return set_values_callback_configuration(message);
 		case FID_GET_VALUES_CALLBACK_CONFIGURATION: return get_values_callback_configuration(message, response);
+		case FID_GET_EXPOSURE: return get_exposure(message, response);
+		case FID_SET_EXPOSURE_LIMIT_CONFIGURATION: return set_exposure_limit_configuration(message);
+		case FID_GET_EXPOSURE_LIMIT_CONFIGURATION: return get_exposure_limit_configuration(message, response);
+		case FID_GET_CONCENTRATION_SLOPE: return get_concentration_slope(message, response);
+		case FID_SET_CONCENTRATION_SLOPE_CONFIGURATION: return set_concentration_slope_configuration(message);
+		case FID_GET_CONCENTRATION_SLOPE_CONFIGURATION: return get_concentration_slope_configuration(message, response);
+		case FID_SET_CONCENTRATION_SLOPE_CALLBACK_CONFIGURATION: return set_concentration_slope_callback_configuration(message);
+		case FID_GET_CONCENTRATION_SLOPE_CALLBACK_CONFIGURATION: return get_concentration_slope_callback_configuration(message, response);
+		case FID_SAVE_CONFIGURATION: return save_configuration(message);
+		case FID_RESTORE_CONFIGURATION: return restore_configuration(message);
+		case FID_GET_I2C_ERROR_COUNT: return get_i2c_error_count(message, response);
+		case FID_GET_MAIN_LOOP_STATISTICS: return get_main_loop_statistics(message, response);
+		case FID_READ_TRACE: return read_trace(message, response);
+		case FID_SET_SENSOR_TABLE: return set_sensor_table(message);
+		case FID_GET_SENSOR_TABLE: return get_sensor_table(message, response);
+		case FID_RESET_SENSOR_TABLE: return reset_sensor_table(message);
+		case FID_GET_VALUES_EXTENDED: return get_values_extended(message, response);
+		case FID_SET_OUTLIER_FILTER_CONFIGURATION: return set_outlier_filter_configuration(message);
+		case FID_GET_OUTLIER_FILTER_CONFIGURATION: return get_outlier_filter_configuration(message, response);
+		case FID_GET_OUTLIER_FILTER_COUNT: return get_outlier_filter_count(message, response);
+		case FID_SET_BASELINE_TRACKING_CONFIGURATION: return set_baseline_tracking_configuration(message);
+		case FID_GET_BASELINE_TRACKING_CONFIGURATION: return get_baseline_tracking_configuration(message, response);
+		case FID_GET_BASELINE_OFFSET: return get_baseline_offset(message, response);
+		case FID_SET_LOW_POWER_CONFIGURATION: return set_low_power_configuration(message);
+		case FID_GET_LOW_POWER_CONFIGURATION: return get_low_power_configuration(message, response);
+		case FID_START_CALIBRATION_CAPTURE: return start_calibration_capture(message);
+		case FID_GET_CALIBRATION_CAPTURE: return get_calibration_capture(message, response);
+		case FID_SET_DIAGNOSTIC_CONFIGURATION: return set_diagnostic_configuration(message);
+		case FID_GET_DIAGNOSTIC_CONFIGURATION: return get_diagnostic_configuration(message, response);
+		case FID_GET_DIAGNOSTIC_STATUS: return get_diagnostic_status(message, response);
+		case FID_SET_WATCHDOG_CONFIGURATION: return set_watchdog_configuration(message);
+		case FID_GET_WATCHDOG_CONFIGURATION: return get_watchdog_configuration(message, response);
+		case FID_GET_DATA_AGE: return get_data_age(message, response);
 		default: return HANDLE_MESSAGE_RESPONSE_NOT_SUPPORTED;
 	}
 }
 
 
 BootloaderHandleMessageResponse get_values(const GetValues *data, GetValues_Response *response) {
+	GasSnapshot snapshot;
+	gas_snapshot_read(&snapshot);
+
 	response->header.length     = sizeof(GetValues_Response);
-	response->gas_type          = gas.type;
-	response->humidity          = gas.humidity;
-	response->temperature       = gas.temperature;
-	response->gas_concentration = gas.ppb; // TODO: Round according to sensor
+	response->gas_type          = snapshot.type;
+	response->humidity          = snapshot.humidity;
+	response->temperature       = snapshot.temperature;
+	response->gas_concentration = snapshot.ppb_rounded;
 
 	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
 }
 
 BootloaderHandleMessageResponse get_adc_count(const GetADCCount *data, GetADCCount_Response *response) {
+	GasSnapshot snapshot;
+	gas_snapshot_read(&snapshot);
+
 	response->header.length = sizeof(GetADCCount_Response);
-	response->adc_count     = gas.adc_count;
+	response->adc_count     = snapshot.adc_count;
 
 	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
 }
@@ -74,6 +142,7 @@ BootloaderHandleMessageResponse set_calibration(const SetCalibration *data) {
 	gas.calibration_sensitivity            = data->sensitivity;
 
 	gas.calibration_new                    = true;
+	gas.task_wakeup                        = true;
 
 	return HANDLE_MESSAGE_RESPONSE_EMPTY;
 }
@@ -113,6 +182,356 @@ BootloaderHandleMessageResponse get_values_callback_configuration(const GetValue
 	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
 }
 
+BootloaderHandleMessageResponse get_exposure(const GetExposure *data, GetExposure_Response *response) {
+	response->header.length = sizeof(GetExposure_Response);
+	response->twa           = exposure.twa;
+	response->stel          = exposure.stel;
+	response->minutes       = exposure.minutes;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_exposure_limit_configuration(const SetExposureLimitConfiguration *data) {
+	exposure.twa_limit  = data->twa_limit;
+	exposure.stel_limit = data->stel_limit;
+	exposure_check_limits();
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_exposure_limit_configuration(const GetExposureLimitConfiguration *data, GetExposureLimitConfiguration_Response *response) {
+	response->header.length = sizeof(GetExposureLimitConfiguration_Response);
+	response->twa_limit     = exposure.twa_limit;
+	response->stel_limit    = exposure.stel_limit;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse get_concentration_slope(const GetConcentrationSlope *data, GetConcentrationSlope_Response *response) {
+	GasSnapshot snapshot;
+	gas_snapshot_read(&snapshot);
+
+	response->header.length = sizeof(GetConcentrationSlope_Response);
+	response->slope         = snapshot.slope;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_concentration_slope_configuration(const SetConcentrationSlopeConfiguration *data) {
+	if((data->window_size < SLOPE_WINDOW_MIN) || (data->window_size > SLOPE_WINDOW_MAX)) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	slope_set_window(data->window_size);
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_concentration_slope_configuration(const GetConcentrationSlopeConfiguration *data, GetConcentrationSlopeConfiguration_Response *response) {
+	response->header.length = sizeof(GetConcentrationSlopeConfiguration_Response);
+	response->window_size   = slope.window;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_concentration_slope_callback_configuration(const SetConcentrationSlopeCallbackConfiguration *data) {
+	if(!is_threshold_option_valid(data->option)) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	gas.slope_period              = data->period;
+	gas.slope_value_has_to_change = data->value_has_to_change;
+	gas.slope_option              = data->option;
+	gas.slope_min                 = data->min;
+	gas.slope_max                 = data->max;
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_concentration_slope_callback_configuration(const GetConcentrationSlopeCallbackConfiguration *data, GetConcentrationSlopeCallbackConfiguration_Response *response) {
+	response->header.length       = sizeof(GetConcentrationSlopeCallbackConfiguration_Response);
+	response->period              = gas.slope_period;
+	response->value_has_to_change = gas.slope_value_has_to_change;
+	response->option              = gas.slope_option;
+	response->min                 = gas.slope_min;
+	response->max                 = gas.slope_max;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse save_configuration(const SaveConfiguration *data) {
+	gas.configuration_save = true;
+	gas.task_wakeup = true;
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse restore_configuration(const RestoreConfiguration *data) {
+	gas.configuration_restore = true;
+	gas.task_wakeup = true;
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_i2c_error_count(const GetI2CErrorCount *data, GetI2CErrorCount_Response *response) {
+	response->header.length            = sizeof(GetI2CErrorCount_Response);
+	response->error_count_transfer     = gas.i2c_error_count;
+	response->error_count_bus_recovery = gas.i2c_bus_recovery_count;
+	response->error_count_reinit       = gas.i2c_reinit_count;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse get_main_loop_statistics(const GetMainLoopStatistics *data, GetMainLoopStatistics_Response *response) {
+	response->header.length             = sizeof(GetMainLoopStatistics_Response);
+	response->loops_per_second          = gas.loops_per_second;
+	response->task_resumes_per_second   = gas.resumes_per_second;
+	response->i2c_interrupts_per_second = gas.irqs_per_second;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse read_trace(const ReadTrace *data, ReadTrace_Response *response) {
+	response->header.length = sizeof(ReadTrace_Response);
+	memset(response->events_data, 0, sizeof(response->events_data));
+
+	// Each call drains up to 4 events, the host polls until events_length is 0
+	uint16_t events_lost    = 0;
+	response->events_length = trace_read(response->events_data, sizeof(response->events_data)/sizeof(TraceEvent), &events_lost);
+	response->events_lost   = events_lost;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_sensor_table(const SetSensorTable *data) {
+	if((data->gas_type >= GAS_SENSOR_TABLE_NUM) ||
+	   !lmp91000_is_configuration_valid(data->tiacn, data->refcn, data->modecn)) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	GasSensorTable *table  = &gas.sensor_table[data->gas_type];
+	table->lmp91000[0]     = data->tiacn;
+	table->lmp91000[1]     = data->refcn;
+	table->lmp91000[2]     = data->modecn;
+	table->compensation[0] = data->compensation_zero_low;
+	table->compensation[1] = data->compensation_zero_high;
+	table->compensation[2] = data->compensation_span_low;
+	table->compensation[3] = data->compensation_span_high;
+
+	gas.sensor_table_custom |= 1 << data->gas_type;
+	gas.sensor_table_new     = true;
+	gas.task_wakeup          = true;
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_sensor_table(const GetSensorTable *data, GetSensorTable_Response *response) {
+	if(data->gas_type >= GAS_SENSOR_TABLE_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	const GasSensorTable *table      = &gas.sensor_table[data->gas_type];
+	response->header.length          = sizeof(GetSensorTable_Response);
+	response->tiacn                  = table->lmp91000[0];
+	response->refcn                  = table->lmp91000[1];
+	response->modecn                 = table->lmp91000[2];
+	response->compensation_zero_low  = table->compensation[0];
+	response->compensation_zero_high = table->compensation[1];
+	response->compensation_span_low  = table->compensation[2];
+	response->compensation_span_high = table->compensation[3];
+	response->custom                 = gas.sensor_table_custom & (1 << data->gas_type);
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse reset_sensor_table(const ResetSensorTable *data) {
+	if(data->gas_type >= GAS_SENSOR_TABLE_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	gas_sensor_table_default(data->gas_type);
+
+	gas.sensor_table_new = true;
+	gas.task_wakeup      = true;
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_values_extended(const GetValuesExtended *data, GetValuesExtended_Response *response) {
+	GasSnapshot snapshot;
+	gas_snapshot_read(&snapshot);
+
+	const uint32_t time = system_timer_get_ms();
+
+	response->header.length            = sizeof(GetValuesExtended_Response);
+	response->gas_type                 = snapshot.type;
+	response->humidity                 = snapshot.humidity;
+	response->temperature              = snapshot.temperature;
+	response->gas_concentration        = snapshot.ppb_rounded;
+	response->resolution               = snapshot.resolution;
+	response->gas_concentration_age    = time - snapshot.adc_update_time;
+	response->temperature_humidity_age = time - snapshot.hdc1080_update_time;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_outlier_filter_configuration(const SetOutlierFilterConfiguration *data) {
+	if((data->mode > GAS_OUTLIER_FILTER_MODE_MAD) ||
+	   (data->window_size < OUTLIER_WINDOW_MIN) || (data->window_size > OUTLIER_WINDOW_MAX) || !(data->window_size & 1) ||
+	   (data->threshold < OUTLIER_THRESHOLD_MIN)) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	outlier_set_configuration(data->mode, data->window_size, data->threshold);
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_outlier_filter_configuration(const GetOutlierFilterConfiguration *data, GetOutlierFilterConfiguration_Response *response) {
+	response->header.length = sizeof(GetOutlierFilterConfiguration_Response);
+	response->mode          = outlier.mode;
+	response->window_size   = outlier.window;
+	response->threshold     = outlier.threshold;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse get_outlier_filter_count(const GetOutlierFilterCount *data, GetOutlierFilterCount_Response *response) {
+	response->header.length  = sizeof(GetOutlierFilterCount_Response);
+	response->rejected_count = outlier.rejected_count;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_baseline_tracking_configuration(const SetBaselineTrackingConfiguration *data) {
+	if(data->time_constant < BASELINE_TIME_CONSTANT_MIN) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	baseline_set_configuration(data->enable, data->time_constant, data->quiet_threshold, data->limit);
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_baseline_tracking_configuration(const GetBaselineTrackingConfiguration *data, GetBaselineTrackingConfiguration_Response *response) {
+	response->header.length   = sizeof(GetBaselineTrackingConfiguration_Response);
+	response->enable          = baseline.enable;
+	response->time_constant   = baseline.time_constant;
+	response->quiet_threshold = baseline.quiet_threshold;
+	response->limit           = baseline.limit;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse get_baseline_offset(const GetBaselineOffset *data, GetBaselineOffset_Response *response) {
+	response->header.length    = sizeof(GetBaselineOffset_Response);
+	response->offset_adc_count = baseline.offset;
+	response->offset_ppb       = baseline.offset*gas.ppb_per_count;
+	response->quiet_minutes    = baseline.quiet_blocks*(BASELINE_BLOCK_TIME/60000);
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_low_power_configuration(const SetLowPowerConfiguration *data) {
+	if(data->enable && ((data->interval < GAS_LOW_POWER_INTERVAL_MIN) || (data->interval > GAS_LOW_POWER_INTERVAL_MAX))) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	gas.low_power_interval = data->enable ? data->interval : 0;
+	gas.low_power_new      = true;
+	gas.task_wakeup        = true;
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_low_power_configuration(const GetLowPowerConfiguration *data, GetLowPowerConfiguration_Response *response) {
+	response->header.length = sizeof(GetLowPowerConfiguration_Response);
+	response->enable        = gas.low_power_interval != 0;
+	response->interval      = gas.low_power_interval;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse start_calibration_capture(const StartCalibrationCapture *data) {
+	if((data->sample_count < CAPTURE_SAMPLES_MIN) || (data->sample_count > CAPTURE_SAMPLES_MAX)) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	capture_start(data->sample_count);
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_calibration_capture(const GetCalibrationCapture *data, GetCalibrationCapture_Response *response) {
+	response->header.length     = sizeof(GetCalibrationCapture_Response);
+	response->state             = capture.state;
+	response->sample_count      = capture.count;
+	response->adc_count_mean    = capture.mean*100.0;
+	response->adc_count_std_dev = capture_get_std_dev();
+	response->current           = capture.mean*gas.na_per_count*1000.0;
+	response->temperature       = capture_get_temperature();
+	response->humidity          = capture_get_humidity();
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_diagnostic_configuration(const SetDiagnosticConfiguration *data) {
+	if(((data->interval != 0) && ((data->interval < DIAGNOSTIC_INTERVAL_MIN) || (data->interval > DIAGNOSTIC_INTERVAL_MAX))) ||
+	   (data->response_min > DIAGNOSTIC_RESPONSE_MIN_MAX)) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	diagnostic_set_configuration(data->interval, data->response_min);
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_diagnostic_configuration(const GetDiagnosticConfiguration *data, GetDiagnosticConfiguration_Response *response) {
+	response->header.length = sizeof(GetDiagnosticConfiguration_Response);
+	response->interval      = diagnostic.interval;
+	response->response_min  = diagnostic.response_min;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse get_diagnostic_status(const GetDiagnosticStatus *data, GetDiagnosticStatus_Response *response) {
+	response->header.length        = sizeof(GetDiagnosticStatus_Response);
+	response->status               = diagnostic.status;
+	response->response             = diagnostic.response;
+	response->run_count            = diagnostic.run_count;
+	response->register_error_count = diagnostic.register_error_count;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_watchdog_configuration(const SetWatchdogConfiguration *data) {
+	if((data->timeout != 0) && ((data->timeout < GAS_WATCHDOG_TIMEOUT_MIN) || (data->timeout > GAS_WATCHDOG_TIMEOUT_MAX))) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	gas.watchdog_timeout = data->timeout;
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_watchdog_configuration(const GetWatchdogConfiguration *data, GetWatchdogConfiguration_Response *response) {
+	response->header.length = sizeof(GetWatchdogConfiguration_Response);
+	response->timeout       = gas.watchdog_timeout;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse get_data_age(const GetDataAge *data, GetDataAge_Response *response) {
+	const uint32_t time = system_timer_get_ms();
+
+	response->header.length            = sizeof(GetDataAge_Response);
+	response->adc_count_age            = time - gas.adc_update_time;
+	response->temperature_humidity_age = time - gas.hdc1080_update_time;
+	response->recovery_count           = gas.watchdog_recovery_count;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
 
 bool handle_values_callback(void) {
 	static bool is_buffered = false;
@@ -129,18 +548,23 @@ bool handle_values_callback(void) {
 			return false;
 		}
 
-		if(gas.ppb         == last_gas_concentration && // TODO: calculate per sensor type
-		   gas.temperature == last_temperature &&
-		   gas.humidity    == last_humidity &&
-		   gas.type        == last_gas_type) {
+		GasSnapshot snapshot;
+		gas_snapshot_read(&snapshot);
+
+		// Compared after rounding, changes below the resolution of the sensor are noise
+		if(gas.value_has_to_change &&
+		   snapshot.ppb_rounded == last_gas_concentration &&
+		   snapshot.temperature == last_temperature &&
+		   snapshot.humidity    == last_humidity &&
+		   snapshot.type        == last_gas_type) {
 			return false;
 		}
 
 		tfp_make_default_header(&cb.header, bootloader_get_uid(), sizeof(Values_Callback), FID_CALLBACK_VALUES);
-		cb.gas_concentration   = gas.ppb; // TODO: calculate per sensor type
-		cb.gas_type            = gas.type;
-		cb.humidity            = gas.humidity;
-		cb.temperature         = gas.temperature;
+		cb.gas_concentration   = snapshot.ppb_rounded;
+		cb.gas_type            = snapshot.type;
+		cb.humidity            = snapshot.humidity;
+		cb.temperature         = snapshot.temperature;
 
 		last_gas_concentration = cb.gas_concentration;
 		last_gas_type          = cb.gas_type;
@@ -161,6 +585,80 @@ bool handle_values_callback(void) {
 	return false;
 }
 
+bool handle_exposure_limit_callback(void) {
+	static bool is_buffered = false;
+	static ExposureLimit_Callback cb;
+
+	static uint8_t last_limit_exceeded = 0;
+
+	if(!is_buffered) {
+		// Triggered once if a limit is exceeded and once if
+		// the exposure is below all limits again.
+		if(exposure.limit_exceeded == last_limit_exceeded) {
+			return false;
+		}
+
+		tfp_make_default_header(&cb.header, bootloader_get_uid(), sizeof(ExposureLimit_Callback), FID_CALLBACK_EXPOSURE_LIMIT);
+		cb.twa              = exposure.twa;
+		cb.stel             = exposure.stel;
+		cb.twa_exceeded     = exposure.limit_exceeded & EXPOSURE_LIMIT_TWA;
+		cb.stel_exceeded    = exposure.limit_exceeded & EXPOSURE_LIMIT_STEL;
+
+		last_limit_exceeded = exposure.limit_exceeded;
+	}
+
+	if(bootloader_spitfp_is_send_possible(&bootloader_status.st)) {
+		bootloader_spitfp_send_ack_and_message(&bootloader_status, (uint8_t*)&cb, sizeof(ExposureLimit_Callback));
+		is_buffered = false;
+		return true;
+	} else {
+		is_buffered = true;
+	}
+
+	return false;
+}
+
+bool handle_concentration_slope_callback(void) {
+	static bool is_buffered = false;
+	static ConcentrationSlope_Callback cb;
+
+	static uint32_t last_time  = 0;
+	static int32_t  last_slope = 0;
+
+	if(!is_buffered) {
+		if(gas.slope_period == 0 || !system_timer_is_time_elapsed_ms(last_time, gas.slope_period)) {
+			return false;
+		}
+
+		GasSnapshot snapshot;
+		gas_snapshot_read(&snapshot);
+
+		if(gas.slope_value_has_to_change && (snapshot.slope == last_slope)) {
+			return false;
+		}
+
+		if(!is_threshold_met(gas.slope_option, snapshot.slope, gas.slope_min, gas.slope_max)) {
+			return false;
+		}
+
+		tfp_make_default_header(&cb.header, bootloader_get_uid(), sizeof(ConcentrationSlope_Callback), FID_CALLBACK_CONCENTRATION_SLOPE);
+		cb.slope   = snapshot.slope;
+
+		last_slope = cb.slope;
+		last_time  = system_timer_get_ms();
+	}
+
+	if(bootloader_spitfp_is_send_possible(&bootloader_status.st)) {
+		bootloader_spitfp_send_ack_and_message(&bootloader_status, (uint8_t*)&cb, sizeof(ConcentrationSlope_Callback));
+		is_buffered = false;
+		return true;
+	} else {
+		is_buffered = true;
+	}
+
+	return false;
+}
+
 void communication_tick(void) {
 	communication_callback_tick();
 }
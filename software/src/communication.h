@@ -41,6 +41,8 @@ void communication_init(void);
 #define GAS_THRESHOLD_OPTION_SMALLER '<'
 #define GAS_THRESHOLD_OPTION_GREATER '>'
 
+bool is_threshold_option_valid(const char option);
+
 #define GAS_GAS_TYPE_CO 0
 #define GAS_GAS_TYPE_ETOH 1
 #define GAS_GAS_TYPE_H2S 2
@@ -64,6 +66,21 @@ void communication_init(void);
 #define GAS_BOOTLOADER_STATUS_DEVICE_IDENTIFIER_INCORRECT 4
 #define GAS_BOOTLOADER_STATUS_CRC_MISMATCH 5
 
+#define GAS_OUTLIER_FILTER_MODE_OFF 0
+#define GAS_OUTLIER_FILTER_MODE_MEDIAN 1
+#define GAS_OUTLIER_FILTER_MODE_MAD 2
+
+#define GAS_CAPTURE_STATE_IDLE 0
+#define GAS_CAPTURE_STATE_RUNNING 1
+#define GAS_CAPTURE_STATE_DONE 2
+
+#define GAS_DIAGNOSTIC_STATUS_NOT_RUN 0
+#define GAS_DIAGNOSTIC_STATUS_OK 1
+#define GAS_DIAGNOSTIC_STATUS_REGISTER_ERROR 2
+#define GAS_DIAGNOSTIC_STATUS_NO_RESPONSE 3
+#define GAS_DIAGNOSTIC_STATUS_SATURATED 4
+#define GAS_DIAGNOSTIC_STATUS_NOT_RECOVERED 5
+
 #define GAS_STATUS_LED_CONFIG_OFF 0
 #define GAS_STATUS_LED_CONFIG_ON 1
 #define GAS_STATUS_LED_CONFIG_SHOW_HEARTBEAT 2
@@ -76,8 +93,43 @@ void communication_init(void);
 #define FID_GET_CALIBRATION 4
 #define FID_SET_VALUES_CALLBACK_CONFIGURATION 5
 #define FID_GET_VALUES_CALLBACK_CONFIGURATION 6
+#define FID_GET_EXPOSURE 8
+#define FID_SET_EXPOSURE_LIMIT_CONFIGURATION 9
+#define FID_GET_EXPOSURE_LIMIT_CONFIGURATION 10
+#define FID_GET_CONCENTRATION_SLOPE 12
+#define FID_SET_CONCENTRATION_SLOPE_CONFIGURATION 13
+#define FID_GET_CONCENTRATION_SLOPE_CONFIGURATION 14
+#define FID_SET_CONCENTRATION_SLOPE_CALLBACK_CONFIGURATION 15
+#define FID_GET_CONCENTRATION_SLOPE_CALLBACK_CONFIGURATION 16
+#define FID_SAVE_CONFIGURATION 18
+#define FID_RESTORE_CONFIGURATION 19
+#define FID_GET_I2C_ERROR_COUNT 20
+#define FID_GET_MAIN_LOOP_STATISTICS 21
+#define FID_READ_TRACE 22
+#define FID_SET_SENSOR_TABLE 23
+#define FID_GET_SENSOR_TABLE 24
+#define FID_RESET_SENSOR_TABLE 25
+#define FID_GET_VALUES_EXTENDED 26
+#define FID_SET_OUTLIER_FILTER_CONFIGURATION 27
+#define FID_GET_OUTLIER_FILTER_CONFIGURATION 28
+#define FID_GET_OUTLIER_FILTER_COUNT 29
+#define FID_SET_BASELINE_TRACKING_CONFIGURATION 30
+#define FID_GET_BASELINE_TRACKING_CONFIGURATION 31
+#define FID_GET_BASELINE_OFFSET 32
+#define FID_SET_LOW_POWER_CONFIGURATION 33
+#define FID_GET_LOW_POWER_CONFIGURATION 34
+#define FID_START_CALIBRATION_CAPTURE 35
+#define FID_GET_CALIBRATION_CAPTURE 36
+#define FID_SET_DIAGNOSTIC_CONFIGURATION 40
+#define FID_GET_DIAGNOSTIC_CONFIGURATION 41
+#define FID_GET_DIAGNOSTIC_STATUS 42
+#define FID_SET_WATCHDOG_CONFIGURATION 43
+#define FID_GET_WATCHDOG_CONFIGURATION 44
+#define FID_GET_DATA_AGE 45
 
 #define FID_CALLBACK_VALUES 7
+#define FID_CALLBACK_EXPOSURE_LIMIT 11
+#define FID_CALLBACK_CONCENTRATION_SLOPE 17
 
 typedef struct {
 	TFPMessageHeader header;
@@ -164,6 +216,328 @@ typedef struct {
 	uint8_t gas_type;
 } __attribute__((__packed__)) Values_Callback;
 
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetExposure;
+
+typedef struct {
+	TFPMessageHeader header;
+	int32_t twa;
+	int32_t stel;
+	uint16_t minutes;
+} __attribute__((__packed__)) GetExposure_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t twa_limit;
+	uint32_t stel_limit;
+} __attribute__((__packed__)) SetExposureLimitConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetExposureLimitConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t twa_limit;
+	uint32_t stel_limit;
+} __attribute__((__packed__)) GetExposureLimitConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	int32_t twa;
+	int32_t stel;
+	bool twa_exceeded;
+	bool stel_exceeded;
+} __attribute__((__packed__)) ExposureLimit_Callback;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetConcentrationSlope;
+
+typedef struct {
+	TFPMessageHeader header;
+	int32_t slope;
+} __attribute__((__packed__)) GetConcentrationSlope_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t window_size;
+} __attribute__((__packed__)) SetConcentrationSlopeConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetConcentrationSlopeConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t window_size;
+} __attribute__((__packed__)) GetConcentrationSlopeConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t period;
+	bool value_has_to_change;
+	char option;
+	int32_t min;
+	int32_t max;
+} __attribute__((__packed__)) SetConcentrationSlopeCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetConcentrationSlopeCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t period;
+	bool value_has_to_change;
+	char option;
+	int32_t min;
+	int32_t max;
+} __attribute__((__packed__)) GetConcentrationSlopeCallbackConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	int32_t slope;
+} __attribute__((__packed__)) ConcentrationSlope_Callback;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) SaveConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) RestoreConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetI2CErrorCount;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t error_count_transfer;
+	uint32_t error_count_bus_recovery;
+	uint32_t error_count_reinit;
+} __attribute__((__packed__)) GetI2CErrorCount_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetMainLoopStatistics;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t loops_per_second;
+	uint32_t task_resumes_per_second;
+	uint32_t i2c_interrupts_per_second;
+} __attribute__((__packed__)) GetMainLoopStatistics_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) ReadTrace;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint16_t events_lost;
+	uint8_t events_length;
+	uint8_t events_data[48];
+} __attribute__((__packed__)) ReadTrace_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t gas_type;
+	uint8_t tiacn;
+	uint8_t refcn;
+	uint8_t modecn;
+	int32_t compensation_zero_low;
+	int32_t compensation_zero_high;
+	int32_t compensation_span_low;
+	int32_t compensation_span_high;
+} __attribute__((__packed__)) SetSensorTable;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t gas_type;
+} __attribute__((__packed__)) GetSensorTable;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t tiacn;
+	uint8_t refcn;
+	uint8_t modecn;
+	int32_t compensation_zero_low;
+	int32_t compensation_zero_high;
+	int32_t compensation_span_low;
+	int32_t compensation_span_high;
+	bool custom;
+} __attribute__((__packed__)) GetSensorTable_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t gas_type;
+} __attribute__((__packed__)) ResetSensorTable;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetValuesExtended;
+
+typedef struct {
+	TFPMessageHeader header;
+	int32_t gas_concentration;
+	int16_t temperature;
+	uint16_t humidity;
+	uint8_t gas_type;
+	uint32_t resolution;
+	uint32_t gas_concentration_age;
+	uint32_t temperature_humidity_age;
+} __attribute__((__packed__)) GetValuesExtended_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t mode;
+	uint8_t window_size;
+	uint16_t threshold;
+} __attribute__((__packed__)) SetOutlierFilterConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetOutlierFilterConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t mode;
+	uint8_t window_size;
+	uint16_t threshold;
+} __attribute__((__packed__)) GetOutlierFilterConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetOutlierFilterCount;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t rejected_count;
+} __attribute__((__packed__)) GetOutlierFilterCount_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool enable;
+	uint16_t time_constant;
+	uint32_t quiet_threshold;
+	uint32_t limit;
+} __attribute__((__packed__)) SetBaselineTrackingConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetBaselineTrackingConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool enable;
+	uint16_t time_constant;
+	uint32_t quiet_threshold;
+	uint32_t limit;
+} __attribute__((__packed__)) GetBaselineTrackingConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetBaselineOffset;
+
+typedef struct {
+	TFPMessageHeader header;
+	int32_t offset_adc_count;
+	int32_t offset_ppb;
+	uint32_t quiet_minutes;
+} __attribute__((__packed__)) GetBaselineOffset_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool enable;
+	uint32_t interval;
+} __attribute__((__packed__)) SetLowPowerConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetLowPowerConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool enable;
+	uint32_t interval;
+} __attribute__((__packed__)) GetLowPowerConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint16_t sample_count;
+} __attribute__((__packed__)) StartCalibrationCapture;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetCalibrationCapture;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t state;
+	uint16_t sample_count;
+	int32_t adc_count_mean;
+	uint32_t adc_count_std_dev;
+	int32_t current;
+	int16_t temperature;
+	uint16_t humidity;
+} __attribute__((__packed__)) GetCalibrationCapture_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t interval;
+	uint32_t response_min;
+} __attribute__((__packed__)) SetDiagnosticConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetDiagnosticConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t interval;
+	uint32_t response_min;
+} __attribute__((__packed__)) GetDiagnosticConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetDiagnosticStatus;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t status;
+	uint32_t response;
+	uint32_t run_count;
+	uint32_t register_error_count;
+} __attribute__((__packed__)) GetDiagnosticStatus_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t timeout;
+} __attribute__((__packed__)) SetWatchdogConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetWatchdogConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t timeout;
+} __attribute__((__packed__)) GetWatchdogConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetDataAge;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t adc_count_age;
+	uint32_t temperature_humidity_age;
+	uint32_t recovery_count;
+} __attribute__((__packed__)) GetDataAge_Response;
+
 
 // Function prototypes
 BootloaderHandleMessageResponse get_values(const GetValues *data, GetValues_Response *response);
@@ -172,14 +546,51 @@ BootloaderHandleMessageResponse set_calibration(const SetCalibration *data);
 BootloaderHandleMessageResponse get_calibration(const GetCalibration *data, GetCalibration_Response *response);
 BootloaderHandleMessageResponse set_values_callback_configuration(const SetValuesCallbackConfiguration *data);
 BootloaderHandleMessageResponse get_values_callback_configuration(const GetValuesCallbackConfiguration *data, GetValuesCallbackConfiguration_Response *response);
+BootloaderHandleMessageResponse get_exposure(const GetExposure *data, GetExposure_Response *response);
+BootloaderHandleMessageResponse set_exposure_limit_configuration(const SetExposureLimitConfiguration *data);
+BootloaderHandleMessageResponse get_exposure_limit_configuration(const GetExposureLimitConfiguration *data, GetExposureLimitConfiguration_Response *response);
+BootloaderHandleMessageResponse get_concentration_slope(const GetConcentrationSlope *data, GetConcentrationSlope_Response *response);
+BootloaderHandleMessageResponse set_concentration_slope_configuration(const SetConcentrationSlopeConfiguration *data);
+BootloaderHandleMessageResponse get_concentration_slope_configuration(const GetConcentrationSlopeConfiguration *data, GetConcentrationSlopeConfiguration_Response *response);
+BootloaderHandleMessageResponse set_concentration_slope_callback_configuration(const SetConcentrationSlopeCallbackConfiguration *data);
+BootloaderHandleMessageResponse get_concentration_slope_callback_configuration(const GetConcentrationSlopeCallbackConfiguration *data, GetConcentrationSlopeCallbackConfiguration_Response *response);
+BootloaderHandleMessageResponse save_configuration(const SaveConfiguration *data);
+BootloaderHandleMessageResponse restore_configuration(const RestoreConfiguration *data);
+BootloaderHandleMessageResponse get_i2c_error_count(const GetI2CErrorCount *data, GetI2CErrorCount_Response *response);
+BootloaderHandleMessageResponse get_main_loop_statistics(const GetMainLoopStatistics *data, GetMainLoopStatistics_Response *response);
+BootloaderHandleMessageResponse read_trace(const ReadTrace *data, ReadTrace_Response *response);
+BootloaderHandleMessageResponse set_sensor_table(const SetSensorTable *data);
+BootloaderHandleMessageResponse get_sensor_table(const GetSensorTable *data, GetSensorTable_Response *response);
+BootloaderHandleMessageResponse reset_sensor_table(const ResetSensorTable *data);
+BootloaderHandleMessageResponse get_values_extended(const GetValuesExtended *data, GetValuesExtended_Response *response);
+BootloaderHandleMessageResponse set_outlier_filter_configuration(const SetOutlierFilterConfiguration *data);
+BootloaderHandleMessageResponse get_outlier_filter_configuration(const GetOutlierFilterConfiguration *data, GetOutlierFilterConfiguration_Response *response);
+BootloaderHandleMessageResponse get_outlier_filter_count(const GetOutlierFilterCount *data, GetOutlierFilterCount_Response *response);
+BootloaderHandleMessageResponse set_baseline_tracking_configuration(const SetBaselineTrackingConfiguration *data);
+BootloaderHandleMessageResponse get_baseline_tracking_configuration(const GetBaselineTrackingConfiguration *data, GetBaselineTrackingConfiguration_Response *response);
+BootloaderHandleMessageResponse get_baseline_offset(const GetBaselineOffset *data, GetBaselineOffset_Response *response);
+BootloaderHandleMessageResponse set_low_power_configuration(const SetLowPowerConfiguration *data);
+BootloaderHandleMessageResponse get_low_power_configuration(const GetLowPowerConfiguration *data, GetLowPowerConfiguration_Response *response);
+BootloaderHandleMessageResponse start_calibration_capture(const StartCalibrationCapture *data);
+BootloaderHandleMessageResponse get_calibration_capture(const GetCalibrationCapture *data, GetCalibrationCapture_Response *response);
+BootloaderHandleMessageResponse set_diagnostic_configuration(const SetDiagnosticConfiguration *data);
+BootloaderHandleMessageResponse get_diagnostic_configuration(const GetDiagnosticConfiguration *data, GetDiagnosticConfiguration_Response *response);
+BootloaderHandleMessageResponse get_diagnostic_status(const GetDiagnosticStatus *data, GetDiagnosticStatus_Response *response);
+BootloaderHandleMessageResponse set_watchdog_configuration(const SetWatchdogConfiguration *data);
+BootloaderHandleMessageResponse get_watchdog_configuration(const GetWatchdogConfiguration *data, GetWatchdogConfiguration_Response *response);
+BootloaderHandleMessageResponse get_data_age(const GetDataAge *data, GetDataAge_Response *response);
 
 // Callbacks
 bool handle_values_callback(void);
+bool handle_exposure_limit_callback(void);
+bool handle_concentration_slope_callback(void);
 
 #define COMMUNICATION_CALLBACK_TICK_WAIT_MS 1
-#define COMMUNICATION_CALLBACK_HANDLER_NUM 1
+#define COMMUNICATION_CALLBACK_HANDLER_NUM 3
 #define COMMUNICATION_CALLBACK_LIST_INIT \
 	handle_values_callback, \
+	handle_exposure_limit_callback, \
+	handle_concentration_slope_callback, \
 
 
 #endif
@@ -45,6 +45,10 @@
 #define GAS_SDA_FIFO_SIZE        XMC_USIC_CH_FIFO_SIZE_16WORDS
 #define GAS_SDA_FIFO_POINTER     48
 
+#define GAS_I2C_SERVICE_REQUEST  2  // SPITFP uses service request 0 and 1
+#define GAS_I2C_IRQ              11 // USIC0 service request 2
+#define GAS_I2C_IRQ_PRIORITY     3
+
 #define GAS_TYPE0_PIN            P2_1
 #define GAS_TYPE1_PIN            P2_2
 #define GAS_TYPE2_PIN            P2_6
@@ -0,0 +1,32 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * config_trace.h: Binary trace configuration for Gas Bricklet
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef CONFIG_TRACE_H
+#define CONFIG_TRACE_H
+
+// Trace events are cheap enough (a few stores into a RAM ring buffer)
+// to stay enabled in release builds. Comment out to remove them.
+#define TRACE_ENABLE
+
+#define TRACE_BUFFER_SIZE 32 // Has to be power of 2
+#define TRACE_BUFFER_MASK (TRACE_BUFFER_SIZE-1)
+
+#endif
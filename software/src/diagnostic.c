@@ -0,0 +1,208 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * diagnostic.c: Background sensor health diagnostic
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "diagnostic.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "bricklib2/hal/system_timer/system_timer.h"
+
+#include "gas.h"
+#include "lmp91000.h"
+#include "capture.h"
+#include "trace.h"
+
+// A disconnected, dried-out or shorted cell still results in a plausible
+// ADC count. Once per interval the diagnostic reads the LMP91000 registers
+// back and applies a short bias step. The double layer capacitance of a
+// working cell answers the step with a large charging current, an open or
+// dried-out cell does not. A TIA output at the end of the ADC range (e.g.
+// a shorted cell) is reported before the step.
+//
+// The samples during the step and until the cell recovered are not used,
+// the last sample before the step is processed in their place, so the
+// slope, baseline and exposure keep their time base. The gap is at most
+// DIAGNOSTIC_STEP_SAMPLES + DIAGNOSTIC_RECOVERY_SAMPLES_MAX samples (2.5s),
+// below 1% of the shortest interval. The first sample after a REFCN write
+// is partly converted with the old bias, the response is the largest
+// deviation of the step samples.
+//
+// A cell that is not back within the tolerance at the end of the gap is
+// reported as not recovered, its samples are used again anyway. The
+// discharge after the step goes against the step response and is about
+// as large as it (the measured response can be up to half lower, the first
+// step sample is partly converted without the step). A deviation in step
+// direction or above twice the response is a concentration change and
+// ends the gap right away.
+//
+// In low power mode there are too few samples for the step, only the
+// registers are checked. A run is postponed while a calibration capture
+// is running.
+
+// The ADC count is the 18 bit two's complement result subtracted from
+// 2^18-1, so both ends of the input range are next to 2^17
+#define DIAGNOSTIC_ADC_COUNT_FULL_SCALE (1 << 17)
+
+Diagnostic diagnostic;
+
+static void diagnostic_finish(const uint8_t status) {
+	diagnostic.state  = DIAGNOSTIC_STATE_IDLE;
+	diagnostic.status = status;
+
+	trace(TRACE_EVENT_DIAGNOSTIC, status, diagnostic.response);
+}
+
+static int32_t diagnostic_start(const int32_t adc_count) {
+	diagnostic.last_run  = system_timer_get_ms();
+	diagnostic.wait      = diagnostic.interval*1000;
+	diagnostic.response  = 0;
+	diagnostic.direction = 0;
+	diagnostic.run_count++;
+
+	if(!lmp91000_check_configuration()) {
+		// Write the configuration again, the step result would be meaningless
+		diagnostic.register_error_count++;
+		lmp91000_task_init();
+		diagnostic_finish(DIAGNOSTIC_STATUS_REGISTER_ERROR);
+		return adc_count;
+	}
+
+	if(abs(adc_count - DIAGNOSTIC_ADC_COUNT_FULL_SCALE) <= DIAGNOSTIC_SATURATION_MARGIN) {
+		diagnostic_finish(DIAGNOSTIC_STATUS_SATURATED);
+		return adc_count;
+	}
+
+	if(gas.low_power_interval != 0) {
+		diagnostic_finish(DIAGNOSTIC_STATUS_OK);
+		return adc_count;
+	}
+
+	if(lmp91000_set_bias_step(true) != 0) {
+		// Make sure that the bias is not left at the step
+		lmp91000_task_init();
+		diagnostic_finish(DIAGNOSTIC_STATUS_REGISTER_ERROR);
+		return adc_count;
+	}
+
+	diagnostic.state     = DIAGNOSTIC_STATE_STEP;
+	diagnostic.samples   = 0;
+	diagnostic.reference = adc_count;
+
+	return adc_count;
+}
+
+static int32_t diagnostic_replace(void) {
+	diagnostic.replaced = true;
+	return diagnostic.reference;
+}
+
+// Called for every new ADC count, returns the ADC count that is processed
+int32_t diagnostic_add_sample(const int32_t adc_count) {
+	const int32_t  difference = adc_count - diagnostic.reference;
+	const uint32_t deviation  = abs(difference);
+
+	diagnostic.replaced = false;
+
+	switch(diagnostic.state) {
+		case DIAGNOSTIC_STATE_IDLE: {
+			if((diagnostic.interval == 0) ||
+			   (capture.state == CAPTURE_STATE_RUNNING) ||
+			   !system_timer_is_time_elapsed_ms(diagnostic.last_run, diagnostic.wait)) {
+				return adc_count;
+			}
+
+			return diagnostic_start(adc_count);
+		}
+
+		case DIAGNOSTIC_STATE_STEP: {
+			if(deviation > diagnostic.response) {
+				diagnostic.response  = deviation;
+				diagnostic.direction = difference > 0 ? 1 : -1;
+			}
+
+			diagnostic.samples++;
+			if(diagnostic.samples >= DIAGNOSTIC_STEP_SAMPLES) {
+				if(lmp91000_set_bias_step(false) != 0) {
+					lmp91000_task_init();
+				}
+
+				diagnostic.state   = DIAGNOSTIC_STATE_RECOVERY;
+				diagnostic.samples = 0;
+			}
+
+			return diagnostic_replace();
+		}
+
+		case DIAGNOSTIC_STATE_RECOVERY: {
+			// The first sample is partly converted with the step bias
+			diagnostic.samples++;
+			if(diagnostic.samples == 1) {
+				return diagnostic_replace();
+			}
+
+			const bool recovered     = deviation <= DIAGNOSTIC_RECOVERY_TOLERANCE;
+			const bool concentration = !recovered && ((difference*diagnostic.direction > 0) || (deviation > 2*diagnostic.response));
+			if(recovered || concentration) {
+				diagnostic_finish(diagnostic.response >= diagnostic.response_min ? DIAGNOSTIC_STATUS_OK : DIAGNOSTIC_STATUS_NO_RESPONSE);
+				return adc_count;
+			}
+
+			if(diagnostic.samples >= DIAGNOSTIC_RECOVERY_SAMPLES_MAX) {
+				diagnostic_finish(diagnostic.response >= diagnostic.response_min ? DIAGNOSTIC_STATUS_NOT_RECOVERED : DIAGNOSTIC_STATUS_NO_RESPONSE);
+				return adc_count;
+			}
+
+			return diagnostic_replace();
+		}
+	}
+
+	return adc_count;
+}
+
+// Called if the LMP91000 or the measurement is reconfigured during a run
+void diagnostic_abort(void) {
+	if(diagnostic.state == DIAGNOSTIC_STATE_STEP) {
+		lmp91000_set_bias_step(false);
+	}
+
+	diagnostic.state = DIAGNOSTIC_STATE_IDLE;
+}
+
+void diagnostic_set_configuration(const uint32_t interval, const uint32_t response_min) {
+	diagnostic.interval     = interval;
+	diagnostic.response_min = response_min;
+
+	// The next run is one interval after the last run,
+	// the first run is always shortly after the start
+	if(diagnostic.run_count > 0) {
+		diagnostic.wait = interval*1000;
+	}
+}
+
+void diagnostic_init(void) {
+	memset(&diagnostic, 0, sizeof(Diagnostic));
+
+	diagnostic.interval     = DIAGNOSTIC_INTERVAL_DEFAULT;
+	diagnostic.response_min = DIAGNOSTIC_RESPONSE_MIN_DEFAULT;
+	diagnostic.last_run     = system_timer_get_ms();
+	diagnostic.wait         = DIAGNOSTIC_FIRST_RUN_DELAY;
+}
@@ -0,0 +1,75 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * diagnostic.h: Background sensor health diagnostic
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef DIAGNOSTIC_H
+#define DIAGNOSTIC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DIAGNOSTIC_INTERVAL_MIN          300    // in s, keeps the measurement gap below 1%
+#define DIAGNOSTIC_INTERVAL_MAX          604800 // in s, one week
+#define DIAGNOSTIC_INTERVAL_DEFAULT      3600   // in s
+#define DIAGNOSTIC_FIRST_RUN_DELAY       60000  // in ms after start
+#define DIAGNOSTIC_RESPONSE_MIN_DEFAULT  50     // in ADC counts
+#define DIAGNOSTIC_RESPONSE_MIN_MAX      131072 // in ADC counts, half of the ADC range
+#define DIAGNOSTIC_STEP_SAMPLES          2
+#define DIAGNOSTIC_RECOVERY_SAMPLES_MAX  8
+#define DIAGNOSTIC_RECOVERY_TOLERANCE    16     // in ADC counts
+#define DIAGNOSTIC_SATURATION_MARGIN     64     // in ADC counts
+
+#define DIAGNOSTIC_STATE_IDLE            0
+#define DIAGNOSTIC_STATE_STEP            1
+#define DIAGNOSTIC_STATE_RECOVERY        2
+
+#define DIAGNOSTIC_STATUS_NOT_RUN        0
+#define DIAGNOSTIC_STATUS_OK             1
+#define DIAGNOSTIC_STATUS_REGISTER_ERROR 2
+#define DIAGNOSTIC_STATUS_NO_RESPONSE    3
+#define DIAGNOSTIC_STATUS_SATURATED      4
+#define DIAGNOSTIC_STATUS_NOT_RECOVERED  5
+
+typedef struct {
+	uint32_t interval;     // in s, 0 = disabled
+	uint32_t response_min; // in ADC counts
+
+	uint8_t  state;
+	uint32_t last_run;     // in ms
+	uint32_t wait;         // in ms until the next run
+	uint8_t  samples;      // Samples in the current state
+	int32_t  reference;    // ADC count before the bias step
+	uint32_t response;     // in ADC counts, largest deviation from the reference during the step
+	int8_t   direction;    // Sign of the largest deviation during the step
+	bool     replaced;     // The last sample was replaced by the reference
+
+	uint8_t  status;       // Result of the last run
+	uint32_t run_count;
+	uint32_t register_error_count;
+} Diagnostic;
+
+extern Diagnostic diagnostic;
+
+int32_t diagnostic_add_sample(const int32_t adc_count);
+void diagnostic_abort(void);
+void diagnostic_set_configuration(const uint32_t interval, const uint32_t response_min);
+void diagnostic_init(void);
+
+#endif
@@ -0,0 +1,107 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * exposure.c: Time weighted average (TWA) and short-term exposure (STEL)
+ *             accumulators
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "exposure.h"
+
+#include <string.h>
+
+// The samples are averaged per minute. The STEL is the average of the last
+// 15 per-minute averages. For the TWA the per-minute averages are summed up
+// in slots of 15 minutes, the TWA is the sum of the last 32 slots divided by
+// 8 hours. Since the oldest slot is dropped when a new slot is started, the
+// TWA window covers between 7:45 and 8:00 hours.
+// The TWA is always divided by the fixed 8 hours and not by the elapsed time,
+// as the 8 hour TWA of the exposure limits is defined. Minutes before the
+// start of the Bricklet count as zero exposure, so within the first 8 hours
+// the TWA grows towards the average concentration. The average over the
+// elapsed time is twa*EXPOSURE_TWA_MINUTES/minutes.
+// The memory used is constant and independent of the sample rate.
+
+Exposure exposure;
+
+static void exposure_close_minute(void) {
+	int32_t average = exposure.minute_last;
+	if(exposure.minute_count > 0) {
+		average = exposure.minute_sum/exposure.minute_count;
+	}
+
+	exposure.minute_last  = average;
+	exposure.minute_sum   = 0.0;
+	exposure.minute_count = 0;
+
+	// STEL
+	exposure.stel_sum += average - exposure.stel_minutes[exposure.stel_index];
+	exposure.stel_minutes[exposure.stel_index] = average;
+	exposure.stel_index = (exposure.stel_index + 1) % EXPOSURE_STEL_MINUTES;
+
+	// TWA
+	exposure.twa_slots[exposure.twa_index] += average;
+	exposure.twa_sum += average;
+	exposure.twa_slot_minutes++;
+	if(exposure.twa_slot_minutes >= EXPOSURE_STEL_MINUTES) {
+		exposure.twa_slot_minutes = 0;
+		exposure.twa_index        = (exposure.twa_index + 1) % EXPOSURE_TWA_SLOTS;
+		exposure.twa_sum         -= exposure.twa_slots[exposure.twa_index];
+		exposure.twa_slots[exposure.twa_index] = 0;
+	}
+
+	if(exposure.minutes < EXPOSURE_TWA_MINUTES) {
+		exposure.minutes++;
+	}
+
+	exposure.stel = exposure.stel_sum/EXPOSURE_STEL_MINUTES;
+	exposure.twa  = exposure.twa_sum/EXPOSURE_TWA_MINUTES;
+
+	exposure_check_limits();
+}
+
+// The limits are unsigned and the averages signed, both are compared as
+// 64 bit values, so that a limit of 2^31 ppb or more is not negative
+void exposure_check_limits(void) {
+	exposure.limit_exceeded = 0;
+	if((exposure.twa_limit != 0) && ((int64_t)exposure.twa >= (int64_t)exposure.twa_limit)) {
+		exposure.limit_exceeded |= EXPOSURE_LIMIT_TWA;
+	}
+	if((exposure.stel_limit != 0) && ((int64_t)exposure.stel >= (int64_t)exposure.stel_limit)) {
+		exposure.limit_exceeded |= EXPOSURE_LIMIT_STEL;
+	}
+}
+
+void exposure_add_sample(const double ppb, const uint32_t time) {
+	// If no sample was added for more than a minute (should not happen),
+	// the missing minutes are filled with the last average.
+	while((uint32_t)(time - exposure.minute_start) >= EXPOSURE_MINUTE_MS) {
+		exposure_close_minute();
+		exposure.minute_start += EXPOSURE_MINUTE_MS;
+	}
+
+	// A negative concentration is measurement noise around zero,
+	// it must not reduce the accumulated exposure.
+	exposure.minute_sum += ppb > 0.0 ? ppb : 0.0;
+	exposure.minute_count++;
+}
+
+void exposure_init(const uint32_t time) {
+	memset(&exposure, 0, sizeof(Exposure));
+
+	exposure.minute_start = time;
+}
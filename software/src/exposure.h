@@ -0,0 +1,72 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * exposure.h: Time weighted average (TWA) and short-term exposure (STEL)
+ *             accumulators
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef EXPOSURE_H
+#define EXPOSURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define EXPOSURE_MINUTE_MS       60000
+#define EXPOSURE_STEL_MINUTES    15
+#define EXPOSURE_TWA_SLOTS       32 // 32 slots of 15 minutes = 8 hours
+#define EXPOSURE_TWA_MINUTES     (EXPOSURE_TWA_SLOTS*EXPOSURE_STEL_MINUTES)
+
+#define EXPOSURE_LIMIT_TWA       (1 << 0)
+#define EXPOSURE_LIMIT_STEL      (1 << 1)
+
+typedef struct {
+	// Sum of all samples within the current minute
+	double   minute_sum;
+	uint32_t minute_count;
+	uint32_t minute_start;
+	int32_t  minute_last;
+
+	// Ring of per-minute averages (in ppb) for the 15 minute STEL window
+	int32_t  stel_minutes[EXPOSURE_STEL_MINUTES];
+	int64_t  stel_sum;
+	uint8_t  stel_index;
+
+	// Ring of 15 minute sums (in ppb*minutes) for the 8 hour TWA window.
+	// The slot at twa_index is the one that is currently filled.
+	int32_t  twa_slots[EXPOSURE_TWA_SLOTS];
+	int64_t  twa_sum;
+	uint8_t  twa_index;
+	uint8_t  twa_slot_minutes;
+
+	uint16_t minutes; // Number of accumulated minutes, saturates at EXPOSURE_TWA_MINUTES
+
+	int32_t  twa;
+	int32_t  stel;
+
+	uint32_t twa_limit;  // in ppb, 0 = off
+	uint32_t stel_limit; // in ppb, 0 = off
+	uint8_t  limit_exceeded;
+} Exposure;
+
+extern Exposure exposure;
+
+void exposure_check_limits(void);
+void exposure_add_sample(const double ppb, const uint32_t time);
+void exposure_init(const uint32_t time);
+
+#endif
@@ -21,6 +21,8 @@
 
 #include "gas.h"
 
+#include <string.h>
+
 #include "configs/config_gas.h"
 #include "configs/config_lmp91000.h"
 #include "configs/config_mcp3423.h"
@@ -35,6 +37,14 @@
 #include "lmp91000.h"
 #include "hdc1080.h"
 #include "mcp3423.h"
+#include "exposure.h"
+#include "slope.h"
+#include "outlier.h"
+#include "baseline.h"
+#include "capture.h"
+#include "diagnostic.h"
+#include "scheduler.h"
+#include "trace.h"
 
 #define GAS_CALIBRATION_PAGE           1
 #define GAS_CALIBRATION_MAGIC_POS      0
@@ -42,42 +52,173 @@
 #define GAS_CALIBRATION_CHECKSUM_POS   15
 #define GAS_CALIBRATION_MAGIC          0x12345678
 
+#define GAS_CONFIGURATION_PAGE         2
+#define GAS_CONFIGURATION_MAGIC_POS    0
+#define GAS_CONFIGURATION_VERSION_POS  1
+#define GAS_CONFIGURATION_DATA_POS     2 // 2 to 62
+#define GAS_CONFIGURATION_CHECKSUM_POS 63
+#define GAS_CONFIGURATION_MAGIC        0x87654321
+#define GAS_CONFIGURATION_VERSION      8
+
+#define GAS_SENSOR_TABLE_PAGE          3
+#define GAS_SENSOR_TABLE_MAGIC_POS     0
+#define GAS_SENSOR_TABLE_VERSION_POS   1
+#define GAS_SENSOR_TABLE_CUSTOM_POS    2
+#define GAS_SENSOR_TABLE_DATA_POS      3 // 3 to 47, 5 per gas type
+#define GAS_SENSOR_TABLE_CHECKSUM_POS  63
+#define GAS_SENSOR_TABLE_MAGIC         0x13572468
+#define GAS_SENSOR_TABLE_VERSION       1
+
 #define GAS_TIME_BETWEEN_INIT_AND_TICK 300 // in ms
 
+#define GAS_I2C_ATTEMPTS               3
+#define GAS_I2C_RECOVERY_CLOCKS        9
+#define GAS_I2C_RECOVERY_DELAY         40
+
 #define GAS_ADC_18BIT_MAX              262143
 #define GAS_TEMPERATURE_THRESHOLD_ZERO 25.0
 #define GAS_TEMPERATURE_THRESHOLD_SPAN 25.0
+#define GAS_RESOLUTION_MAX             1000000 // in ppb
 
 const uint32_t gas_tiagain_to_rgain[8] = {
 	499000, 2735, 3476, 6903, 13618, 32706, 96737, 205713
 };
 
+// Noise floor of the cells in ppb, estimated from the zero noise
+// given in the sensor datasheets. Below this there is no information
+// in the concentration, see gas_update_coefficients.
+const uint16_t gas_noise_floor[GAS_SENSOR_TABLE_NUM] = {
+	100, // CO
+	500, // EtOH
+	 50, // H2S
+	 50, // SO2
+	 20, // NO2
+	 20, // O3
+	100, // IAQ
+	500, // RESP
+	 20, // O3/NO2
+};
+
 // {Zero Low, Zero High, Span Low, Span High}
-const double gas_sensor_compensation[][4] = {
-	{0.0,   2.375, 0.6, 0.4}, // CO
-	{1.7,  22.5,   1.2, 0.0}, // EtOH
-	{0.0,   0.0,   0.3, 0.0}, // H2S
-	{0.0,  15.0,   1.2, 0.5}, // SO2
-	{0.0, - 1.6,   0.0, 0.4}, // NO2
-	{0.0,   0.0,   0.0, 0.5}, // O3
-	{0.0,   0.0,   0.0, 0.0}, // IAQ
-	{0.0,   0.0,   0.0, 0.0}, // RESP
-	{0.0,   0.0,   0.0, 0.0}, // O3/NO
+// Zero in pA/°C, span in %/°C*1000
+const int32_t gas_default_compensation[GAS_SENSOR_TABLE_NUM][4] = {
+	{   0,  2375,  600, 400}, // CO
+	{1700, 22500, 1200,   0}, // EtOH
+	{   0,     0,  300,   0}, // H2S
+	{   0, 15000, 1200, 500}, // SO2
+	{   0, -1600,    0, 400}, // NO2
+	{   0,     0,    0, 500}, // O3
+	{   0,     0,    0,   0}, // IAQ
+	{   0,     0,    0,   0}, // RESP
+	{   0,     0,    0,   0}, // O3/NO
 };
 
 
 CoopTask gas_task;
 Gas gas;
 
-uint32_t gas_task_read_register(const uint8_t address, const I2C_FIFO_REG_TYPE reg, const uint32_t length, uint8_t *data) {
+// The USIC signals all I2C protocol events and received data through
+// this interrupt. It only marks that the transfer made progress, the
+// i2c_fifo state machine itself still runs in the gas task.
+void __attribute__((optimize("-O3"))) __attribute__ ((section (".ram_code"))) IRQ_Hdlr_11(void) {
+	gas.i2c_irq_pending = true;
+	gas.i2c_irq_count++;
+}
+
+static void gas_i2c_init_irq(void) {
+	XMC_USIC_CH_SetInterruptNodePointer(GAS_I2C, XMC_USIC_CH_INTERRUPT_NODE_POINTER_PROTOCOL, GAS_I2C_SERVICE_REQUEST);
+	XMC_USIC_CH_RXFIFO_SetInterruptNodePointer(GAS_I2C, XMC_USIC_CH_RXFIFO_INTERRUPT_NODE_POINTER_STANDARD, GAS_I2C_SERVICE_REQUEST);
+	XMC_USIC_CH_RXFIFO_SetInterruptNodePointer(GAS_I2C, XMC_USIC_CH_RXFIFO_INTERRUPT_NODE_POINTER_ALTERNATE, GAS_I2C_SERVICE_REQUEST);
+
+	XMC_I2C_CH_EnableEvent(GAS_I2C, XMC_I2C_CH_EVENT_ACK | XMC_I2C_CH_EVENT_NACK | XMC_I2C_CH_EVENT_STOP_CONDITION_RECEIVED | XMC_I2C_CH_EVENT_ARBITRATION_LOST | XMC_I2C_CH_EVENT_ERROR);
+	XMC_USIC_CH_RXFIFO_EnableEvent(GAS_I2C, XMC_USIC_CH_RXFIFO_EVENT_CONF_STANDARD | XMC_USIC_CH_RXFIFO_EVENT_CONF_ALTERNATE);
+
+	NVIC_SetPriority(GAS_I2C_IRQ, GAS_I2C_IRQ_PRIORITY);
+	NVIC_EnableIRQ(GAS_I2C_IRQ);
+}
+
+static void gas_i2c_reset(void) {
+	i2c_fifo_init(&gas.i2c_fifo);
+	gas_i2c_init_irq();
+}
+
+static void gas_i2c_lock(void) {
 	while(gas.i2c_mutex) {
 		coop_task_yield();
 	}
 
 	gas.i2c_mutex = true;
-	gas.i2c_fifo.address = address;
+}
+
+static void gas_i2c_delay(void) {
+	// About half of a clock period at 100kHz
+	for(volatile uint32_t i = 0; i < GAS_I2C_RECOVERY_DELAY; i++);
+}
+
+// If a transfer is interrupted, a slave may still hold SDA low and block the bus.
+// We clock SCL by hand until SDA is released and end with a stop condition.
+static void gas_i2c_recover_bus(void) {
+	gas.i2c_bus_recovery_count++;
+
+	XMC_GPIO_CONFIG_t config_open_drain = {
+		.mode         = XMC_GPIO_MODE_OUTPUT_OPEN_DRAIN,
+		.output_level = XMC_GPIO_OUTPUT_LEVEL_HIGH,
+	};
+
+	XMC_GPIO_Init(GAS_SCL_PORT, GAS_SCL_PIN, &config_open_drain);
+	XMC_GPIO_Init(GAS_SDA_PORT, GAS_SDA_PIN, &config_open_drain);
+	gas_i2c_delay();
+
+	for(uint8_t i = 0; (i < GAS_I2C_RECOVERY_CLOCKS) && !XMC_GPIO_GetInput(GAS_SDA_PORT, GAS_SDA_PIN); i++) {
+		XMC_GPIO_SetOutputLow(GAS_SCL_PORT, GAS_SCL_PIN);
+		gas_i2c_delay();
+		XMC_GPIO_SetOutputHigh(GAS_SCL_PORT, GAS_SCL_PIN);
+		gas_i2c_delay();
+	}
+
+	// Stop condition: SDA low -> high while SCL is high
+	XMC_GPIO_SetOutputLow(GAS_SCL_PORT, GAS_SCL_PIN);
+	gas_i2c_delay();
+	XMC_GPIO_SetOutputLow(GAS_SDA_PORT, GAS_SDA_PIN);
+	gas_i2c_delay();
+	XMC_GPIO_SetOutputHigh(GAS_SCL_PORT, GAS_SCL_PIN);
+	gas_i2c_delay();
+	XMC_GPIO_SetOutputHigh(GAS_SDA_PORT, GAS_SDA_PIN);
+	gas_i2c_delay();
+
+	// Give pins back to the USIC
+	gas_i2c_reset();
+}
+
+// Called after a failed transfer, returns true if the transfer is to be retried.
+// The first retry only resets the I2C FIFO, further retries recover the bus first.
+static bool gas_i2c_handle_error(const uint32_t ret, const uint8_t address, const uint8_t attempt) {
+	gas.i2c_error_count++;
+	trace(TRACE_EVENT_I2C_ERROR, ret, (address << 8) | attempt);
+
+	if(attempt + 1 >= GAS_I2C_ATTEMPTS) {
+		return false;
+	}
 
-	uint32_t ret = i2c_fifo_coop_read_register(&gas.i2c_fifo, reg, length, data);
+	if(attempt == 0) {
+		gas_i2c_reset();
+	} else {
+		gas_i2c_recover_bus();
+	}
+
+	return true;
+}
+
+// The i2c_fifo_coop functions return 0 on success
+uint32_t gas_task_read_register(const uint8_t address, const I2C_FIFO_REG_TYPE reg, const uint32_t length, uint8_t *data) {
+	gas_i2c_lock();
+
+	uint32_t ret;
+	uint8_t attempt = 0;
+	do {
+		gas.i2c_fifo.address = address;
+		ret = i2c_fifo_coop_read_register(&gas.i2c_fifo, reg, length, data);
+	} while((ret != 0) && gas_i2c_handle_error(ret, address, attempt++));
 
 	gas.i2c_mutex = false;
 
@@ -85,14 +226,14 @@ uint32_t gas_task_read_register(const uint8_t address, const I2C_FIFO_REG_TYPE r
 }
 
 uint32_t gas_task_write_register(const uint8_t address, const I2C_FIFO_REG_TYPE reg, const uint32_t length, const uint8_t *data, const bool send_stop) {
-	while(gas.i2c_mutex) {
-		coop_task_yield();
-	}
-
-	gas.i2c_mutex = true;
-	gas.i2c_fifo.address = address;
+	gas_i2c_lock();
 
-	uint32_t ret = i2c_fifo_coop_write_register(&gas.i2c_fifo, reg, length, data, send_stop);
+	uint32_t ret;
+	uint8_t attempt = 0;
+	do {
+		gas.i2c_fifo.address = address;
+		ret = i2c_fifo_coop_write_register(&gas.i2c_fifo, reg, length, data, send_stop);
+	} while((ret != 0) && gas_i2c_handle_error(ret, address, attempt++));
 
 	gas.i2c_mutex = false;
 
@@ -100,14 +241,14 @@ uint32_t gas_task_write_register(const uint8_t address, const I2C_FIFO_REG_TYPE
 }
 
 uint32_t gas_task_read_direct(const uint8_t address, const uint32_t length, uint8_t *data, const bool restart) {
-	while(gas.i2c_mutex) {
-		coop_task_yield();
-	}
+	gas_i2c_lock();
 
-	gas.i2c_mutex = true;
-	gas.i2c_fifo.address = address;
-
-	uint32_t ret = i2c_fifo_coop_read_direct(&gas.i2c_fifo, length, data, restart);
+	uint32_t ret;
+	uint8_t attempt = 0;
+	do {
+		gas.i2c_fifo.address = address;
+		ret = i2c_fifo_coop_read_direct(&gas.i2c_fifo, length, data, restart);
+	} while((ret != 0) && gas_i2c_handle_error(ret, address, attempt++));
 
 	gas.i2c_mutex = false;
 
@@ -115,14 +256,14 @@ uint32_t gas_task_read_direct(const uint8_t address, const uint32_t length, uint
 }
 
 uint32_t gas_task_write_direct(const uint8_t address, const uint32_t length, const uint8_t *data, const bool send_stop) {
-	while(gas.i2c_mutex) {
-		coop_task_yield();
-	}
+	gas_i2c_lock();
 
-	gas.i2c_mutex = true;
-	gas.i2c_fifo.address = address;
-
-	uint32_t ret = i2c_fifo_coop_write_direct(&gas.i2c_fifo, length, data, send_stop);
+	uint32_t ret;
+	uint8_t attempt = 0;
+	do {
+		gas.i2c_fifo.address = address;
+		ret = i2c_fifo_coop_write_direct(&gas.i2c_fifo, length, data, send_stop);
+	} while((ret != 0) && gas_i2c_handle_error(ret, address, attempt++));
 
 	gas.i2c_mutex = false;
 
@@ -202,25 +343,443 @@ void gas_calibration_write(void) {
 	bootloader_write_eeprom_page(GAS_CALIBRATION_PAGE, page);
 }
 
-void gas_calculate_ppb(void) {
-	const double rgain            = gas_tiagain_to_rgain[gas.tia_gain];
-	const double zero_low         = gas_sensor_compensation[gas.type][0];
-	const double zero_high        = gas_sensor_compensation[gas.type][1];
-	const double span_low         = gas_sensor_compensation[gas.type][2];
-	const double span_high        = gas_sensor_compensation[gas.type][3];
+// Runtime configuration (callback configurations, exposure limits etc).
+// The version has to be increased if data is added, data of an older
+// version is read as far as it is available, the rest keeps the defaults.
+// Values are checked as by the corresponding setters, a setting with
+// invalid values keeps the defaults.
+void gas_configuration_read(void) {
+	uint32_t page[EEPROM_PAGE_SIZE/sizeof(uint32_t)];
+
+	bootloader_read_eeprom_page(GAS_CONFIGURATION_PAGE, page);
+	uint32_t checksum = 0;
+	for(uint8_t i = 0; i < GAS_CONFIGURATION_CHECKSUM_POS; i++) {
+		checksum = checksum ^ page[i];
+	}
+
+	if(page[GAS_CONFIGURATION_MAGIC_POS] != GAS_CONFIGURATION_MAGIC) {
+		logd("Configuration Read: Wrong magic %x != %x\n\r", page[GAS_CONFIGURATION_MAGIC_POS], GAS_CONFIGURATION_MAGIC);
+		return;
+	}
+
+	if(page[GAS_CONFIGURATION_CHECKSUM_POS] != checksum) {
+		logd("Configuration Read: Wrong checksum %x != %x\n\r", page[GAS_CONFIGURATION_CHECKSUM_POS], checksum);
+		return;
+	}
+
+	const uint32_t version = page[GAS_CONFIGURATION_VERSION_POS];
+	if(version >= 1) {
+		const uint32_t value_has_to_change = page[GAS_CONFIGURATION_DATA_POS +  1];
+		if(value_has_to_change <= 1) {
+			gas.period                    = page[GAS_CONFIGURATION_DATA_POS +  0];
+			gas.value_has_to_change       = value_has_to_change;
+		}
+
+		exposure.twa_limit                = page[GAS_CONFIGURATION_DATA_POS +  2];
+		exposure.stel_limit               = page[GAS_CONFIGURATION_DATA_POS +  3];
+
+		const uint32_t slope_value_has_to_change = page[GAS_CONFIGURATION_DATA_POS +  5];
+		const uint32_t slope_option              = page[GAS_CONFIGURATION_DATA_POS +  6];
+		if((slope_value_has_to_change <= 1) && (slope_option <= UINT8_MAX) && is_threshold_option_valid(slope_option)) {
+			gas.slope_period              = page[GAS_CONFIGURATION_DATA_POS +  4];
+			gas.slope_value_has_to_change = slope_value_has_to_change;
+			gas.slope_option              = slope_option;
+			gas.slope_min                 = page[GAS_CONFIGURATION_DATA_POS +  7];
+			gas.slope_max                 = page[GAS_CONFIGURATION_DATA_POS +  8];
+		}
+
+		const uint32_t slope_window   = page[GAS_CONFIGURATION_DATA_POS +  9];
+		if((slope_window >= SLOPE_WINDOW_MIN) && (slope_window <= SLOPE_WINDOW_MAX)) {
+			slope_set_window(slope_window);
+		}
+
+		exposure_check_limits();
+	}
+
+	if(version >= 2) {
+		const uint32_t outlier_mode      = page[GAS_CONFIGURATION_DATA_POS + 10];
+		const uint32_t outlier_window    = page[GAS_CONFIGURATION_DATA_POS + 11];
+		const uint32_t outlier_threshold = page[GAS_CONFIGURATION_DATA_POS + 12];
+		if((outlier_mode <= OUTLIER_MODE_MAD) &&
+		   (outlier_window >= OUTLIER_WINDOW_MIN) && (outlier_window <= OUTLIER_WINDOW_MAX) && (outlier_window & 1) &&
+		   (outlier_threshold >= OUTLIER_THRESHOLD_MIN) && (outlier_threshold <= UINT16_MAX)) {
+			outlier_set_configuration(outlier_mode, outlier_window, outlier_threshold);
+		}
+	}
+
+	if(version >= 3) {
+		const uint32_t baseline_enable        = page[GAS_CONFIGURATION_DATA_POS + 13];
+		const uint32_t baseline_time_constant = page[GAS_CONFIGURATION_DATA_POS + 14];
+		if((baseline_enable <= 1) && (baseline_time_constant >= BASELINE_TIME_CONSTANT_MIN) && (baseline_time_constant <= UINT16_MAX)) {
+			baseline_set_configuration(baseline_enable,
+			                           baseline_time_constant,
+			                           page[GAS_CONFIGURATION_DATA_POS + 15],
+			                           page[GAS_CONFIGURATION_DATA_POS + 16]);
+
+			// The learned offset is only stored with the configuration, otherwise
+			// it would have to be written to the EEPROM every few minutes. It is
+			// relative to the zero at the time it was stored (position 23 since
+			// version 8), after a new calibration of the zero it is not used.
+			if(baseline.enable && (version >= 8) && (((int32_t)page[GAS_CONFIGURATION_DATA_POS + 23]) == gas.adc_count_zero)) {
+				baseline.offset = ((int32_t)page[GAS_CONFIGURATION_DATA_POS + 17])/256.0;
+				baseline_clamp(gas.ppb_per_count);
+			}
+		}
+	}
+
+	if(version >= 4) {
+		const uint32_t low_power_interval = page[GAS_CONFIGURATION_DATA_POS + 18];
+		if((low_power_interval == 0) || ((low_power_interval >= GAS_LOW_POWER_INTERVAL_MIN) && (low_power_interval <= GAS_LOW_POWER_INTERVAL_MAX))) {
+			gas.low_power_interval = low_power_interval;
+			gas.low_power_new      = true;
+		}
+	}
+
+	// Version 5 added position 19, it is not used anymore
+
+	if(version >= 6) {
+		const uint32_t diagnostic_interval     = page[GAS_CONFIGURATION_DATA_POS + 20];
+		const uint32_t diagnostic_response_min = page[GAS_CONFIGURATION_DATA_POS + 21];
+		if(((diagnostic_interval == 0) || ((diagnostic_interval >= DIAGNOSTIC_INTERVAL_MIN) && (diagnostic_interval <= DIAGNOSTIC_INTERVAL_MAX))) &&
+		   (diagnostic_response_min <= DIAGNOSTIC_RESPONSE_MIN_MAX)) {
+			diagnostic_set_configuration(diagnostic_interval, diagnostic_response_min);
+		}
+	}
+
+	if(version >= 7) {
+		const uint32_t watchdog_timeout = page[GAS_CONFIGURATION_DATA_POS + 22];
+		if((watchdog_timeout == 0) || ((watchdog_timeout >= GAS_WATCHDOG_TIMEOUT_MIN) && (watchdog_timeout <= GAS_WATCHDOG_TIMEOUT_MAX))) {
+			gas.watchdog_timeout = watchdog_timeout;
+		}
+	}
+}
+
+void gas_configuration_write(void) {
+	uint32_t page[EEPROM_PAGE_SIZE/sizeof(uint32_t)] = {0};
+
+	page[GAS_CONFIGURATION_MAGIC_POS    ] = GAS_CONFIGURATION_MAGIC;
+	page[GAS_CONFIGURATION_VERSION_POS  ] = GAS_CONFIGURATION_VERSION;
+
+	page[GAS_CONFIGURATION_DATA_POS +  0] = gas.period;
+	page[GAS_CONFIGURATION_DATA_POS +  1] = gas.value_has_to_change;
+	page[GAS_CONFIGURATION_DATA_POS +  2] = exposure.twa_limit;
+	page[GAS_CONFIGURATION_DATA_POS +  3] = exposure.stel_limit;
+	page[GAS_CONFIGURATION_DATA_POS +  4] = gas.slope_period;
+	page[GAS_CONFIGURATION_DATA_POS +  5] = gas.slope_value_has_to_change;
+	page[GAS_CONFIGURATION_DATA_POS +  6] = gas.slope_option;
+	page[GAS_CONFIGURATION_DATA_POS +  7] = gas.slope_min;
+	page[GAS_CONFIGURATION_DATA_POS +  8] = gas.slope_max;
+	page[GAS_CONFIGURATION_DATA_POS +  9] = slope.window;
+	page[GAS_CONFIGURATION_DATA_POS + 10] = outlier.mode;
+	page[GAS_CONFIGURATION_DATA_POS + 11] = outlier.window;
+	page[GAS_CONFIGURATION_DATA_POS + 12] = outlier.threshold;
+	page[GAS_CONFIGURATION_DATA_POS + 13] = baseline.enable;
+	page[GAS_CONFIGURATION_DATA_POS + 14] = baseline.time_constant;
+	page[GAS_CONFIGURATION_DATA_POS + 15] = baseline.quiet_threshold;
+	page[GAS_CONFIGURATION_DATA_POS + 16] = baseline.limit;
+	page[GAS_CONFIGURATION_DATA_POS + 17] = (int32_t)(baseline.offset*256);
+	page[GAS_CONFIGURATION_DATA_POS + 18] = gas.low_power_interval;
+	page[GAS_CONFIGURATION_DATA_POS + 20] = diagnostic.interval;
+	page[GAS_CONFIGURATION_DATA_POS + 21] = diagnostic.response_min;
+	page[GAS_CONFIGURATION_DATA_POS + 22] = gas.watchdog_timeout;
+	page[GAS_CONFIGURATION_DATA_POS + 23] = gas.adc_count_zero;
+
+	uint32_t checksum = 0;
+	for(uint8_t i = 0; i < GAS_CONFIGURATION_CHECKSUM_POS; i++) {
+		checksum = checksum ^ page[i];
+	}
+
+	page[GAS_CONFIGURATION_CHECKSUM_POS] = checksum;
+
+	bootloader_write_eeprom_page(GAS_CONFIGURATION_PAGE, page);
+}
+
+void gas_sensor_table_default(const uint8_t type) {
+	memcpy(gas.sensor_table[type].lmp91000,     lmp91000_default_configuration[type], sizeof(gas.sensor_table[type].lmp91000));
+	memcpy(gas.sensor_table[type].compensation, gas_default_compensation[type],       sizeof(gas.sensor_table[type].compensation));
+	gas.sensor_table_custom &= ~(1 << type);
+}
+
+void gas_sensor_table_read(void) {
+	for(uint8_t type = 0; type < GAS_SENSOR_TABLE_NUM; type++) {
+		gas_sensor_table_default(type);
+	}
+
+	uint32_t page[EEPROM_PAGE_SIZE/sizeof(uint32_t)];
+
+	bootloader_read_eeprom_page(GAS_SENSOR_TABLE_PAGE, page);
+	uint32_t checksum = 0;
+	for(uint8_t i = 0; i < GAS_SENSOR_TABLE_CHECKSUM_POS; i++) {
+		checksum = checksum ^ page[i];
+	}
+
+	if(page[GAS_SENSOR_TABLE_MAGIC_POS] != GAS_SENSOR_TABLE_MAGIC) {
+		logd("Sensor Table Read: Wrong magic %x != %x\n\r", page[GAS_SENSOR_TABLE_MAGIC_POS], GAS_SENSOR_TABLE_MAGIC);
+		return;
+	}
+
+	if(page[GAS_SENSOR_TABLE_CHECKSUM_POS] != checksum) {
+		logd("Sensor Table Read: Wrong checksum %x != %x\n\r", page[GAS_SENSOR_TABLE_CHECKSUM_POS], checksum);
+		return;
+	}
+
+	// The layout of the tables may differ between versions
+	if(page[GAS_SENSOR_TABLE_VERSION_POS] != GAS_SENSOR_TABLE_VERSION) {
+		logd("Sensor Table Read: Wrong version %d != %d\n\r", page[GAS_SENSOR_TABLE_VERSION_POS], GAS_SENSOR_TABLE_VERSION);
+		return;
+	}
+
+	// Only the uploaded tables are taken from the EEPROM, all
+	// other gas types use the defaults of this firmware version
+	const uint32_t custom = page[GAS_SENSOR_TABLE_CUSTOM_POS];
+	for(uint8_t type = 0; type < GAS_SENSOR_TABLE_NUM; type++) {
+		if(!(custom & (1 << type))) {
+			continue;
+		}
+
+		const uint32_t *data = &page[GAS_SENSOR_TABLE_DATA_POS + type*5];
+		gas.sensor_table[type].lmp91000[0]     = (data[0] >>  0) & 0xFF;
+		gas.sensor_table[type].lmp91000[1]     = (data[0] >>  8) & 0xFF;
+		gas.sensor_table[type].lmp91000[2]     = (data[0] >> 16) & 0xFF;
+		gas.sensor_table[type].compensation[0] = data[1];
+		gas.sensor_table[type].compensation[1] = data[2];
+		gas.sensor_table[type].compensation[2] = data[3];
+		gas.sensor_table[type].compensation[3] = data[4];
+		gas.sensor_table_custom |= 1 << type;
+	}
+}
+
+void gas_sensor_table_write(void) {
+	uint32_t page[EEPROM_PAGE_SIZE/sizeof(uint32_t)] = {0};
+
+	page[GAS_SENSOR_TABLE_MAGIC_POS  ] = GAS_SENSOR_TABLE_MAGIC;
+	page[GAS_SENSOR_TABLE_VERSION_POS] = GAS_SENSOR_TABLE_VERSION;
+	page[GAS_SENSOR_TABLE_CUSTOM_POS ] = gas.sensor_table_custom;
+
+	for(uint8_t type = 0; type < GAS_SENSOR_TABLE_NUM; type++) {
+		uint32_t *data = &page[GAS_SENSOR_TABLE_DATA_POS + type*5];
+		data[0] = gas.sensor_table[type].lmp91000[0] | (gas.sensor_table[type].lmp91000[1] << 8) | (gas.sensor_table[type].lmp91000[2] << 16);
+		data[1] = gas.sensor_table[type].compensation[0];
+		data[2] = gas.sensor_table[type].compensation[1];
+		data[3] = gas.sensor_table[type].compensation[2];
+		data[4] = gas.sensor_table[type].compensation[3];
+	}
+
+	uint32_t checksum = 0;
+	for(uint8_t i = 0; i < GAS_SENSOR_TABLE_CHECKSUM_POS; i++) {
+		checksum = checksum ^ page[i];
+	}
+
+	page[GAS_SENSOR_TABLE_CHECKSUM_POS] = checksum;
+
+	bootloader_write_eeprom_page(GAS_SENSOR_TABLE_PAGE, page);
+}
+
+// Has to be called if the sensor table, the calibration or the gas type
+// changed. Everything that does not depend on the ADC count or the
+// temperature is calculated here once instead of for every sample.
+void gas_update_coefficients(void) {
+	gas.tia_gain      = (gas.sensor_table[gas.type].lmp91000[0] & 0b00011100) >> 2;
+	gas.na_per_count  = 2.048/GAS_ADC_18BIT_MAX/gas_tiagain_to_rgain[gas.tia_gain] * 1E9;
+	gas.ppb_per_na    = 1E5/((double)gas.na_per_ppm);
+
+	// The output resolution is the noise floor of the cell or one ADC count,
+	// whichever is larger, rounded up to a 1-2-5 step
+	double resolution = gas.na_per_count*gas.ppb_per_na;
+	if(resolution < 0) {
+		resolution = -resolution;
+	}
+
+	if(resolution < gas_noise_floor[gas.type]) {
+		resolution = gas_noise_floor[gas.type];
+	}
+
+	// Without sensitivity (not calibrated) there is no meaningful resolution
+	if(!(resolution <= GAS_RESOLUTION_MAX)) {
+		resolution = GAS_RESOLUTION_MAX;
+	}
+
+	uint32_t decade = 1;
+	while(decade*10 <= resolution) {
+		decade *= 10;
+	}
+
+	if(resolution <= decade) {
+		gas.resolution = decade;
+	} else if(resolution <= 2*decade) {
+		gas.resolution = 2*decade;
+	} else if(resolution <= 5*decade) {
+		gas.resolution = 5*decade;
+	} else {
+		gas.resolution = 10*decade;
+	}
+
+	gas.coefficients_temperature_valid = false;
+}
+
+// Rounds half away from zero to a multiple of the resolution
+static int32_t gas_round_to_resolution(const double ppb) {
+	const double steps = ppb/gas.resolution;
+	if(steps >= 0) {
+		return ((int32_t)(steps + 0.5))*((int32_t)gas.resolution);
+	}
+
+	return -((int32_t)(-steps + 0.5))*((int32_t)gas.resolution);
+}
+
+static void gas_update_temperature_coefficients(void) {
+	const int32_t *compensation   = gas.sensor_table[gas.type].compensation;
 	const double temperature      = gas.temperature/100.0;
 
-	const double zero             = temperature < GAS_TEMPERATURE_THRESHOLD_ZERO ? zero_low : zero_high;
-	const double span             = temperature < GAS_TEMPERATURE_THRESHOLD_SPAN ? span_low : span_high;
+	const int32_t zero            = temperature < GAS_TEMPERATURE_THRESHOLD_ZERO ? compensation[0] : compensation[1];
+	const int32_t span            = temperature < GAS_TEMPERATURE_THRESHOLD_SPAN ? compensation[2] : compensation[3];
+
+	const double zero_drift       = zero/1000.0 *         (temperature - GAS_TEMPERATURE_THRESHOLD_ZERO); // in nA
+	const double span_compensated = 1.0 - (span/100000.0 * (temperature - GAS_TEMPERATURE_THRESHOLD_SPAN));
+
+	gas.ppb_per_count                  = gas.na_per_count * span_compensated * gas.ppb_per_na;
+	gas.ppb_zero_drift                 = zero_drift       * span_compensated * gas.ppb_per_na;
+	gas.coefficients_temperature       = gas.temperature;
+	gas.coefficients_temperature_valid = true;
+
+	// The limit of the offset is given in ppb
+	baseline_clamp(gas.ppb_per_count);
+}
+
+void gas_calculate_ppb(void) {
+	if(!gas.coefficients_temperature_valid || (gas.temperature != gas.coefficients_temperature)) {
+		gas_update_temperature_coefficients();
+	}
+
+	gas.ppb = (gas.adc_count - gas.adc_count_zero - baseline.offset)*gas.ppb_per_count - gas.ppb_zero_drift;
+
+	// The temperature compensation is constant within the slope window,
+	// so the slope in ppb is the slope in ADC counts times the ppb per count.
+	gas.slope = slope_get_counts_per_sample() * gas.ppb_per_count * (60000.0/gas_get_sample_period());
+
+	trace(TRACE_EVENT_GAS_CONCENTRATION, (int32_t)(gas.ppb*1000), gas.slope);
+}
+
+
+// Called by the MCP3423 job for every new conversion result. The job runs
+// in the gas task, so there is at most one result between two passes of
+// the task loop.
+void gas_add_sample(const int32_t adc_count) {
+	gas.adc_count_sample     = adc_count;
+	gas.adc_count_sample_new = true;
+}
+
+static void gas_snapshot_publish(void) {
+	gas.snapshot.sequence++;
+	__DMB();
+
+	gas.snapshot.ppb         = gas.ppb;
+	gas.snapshot.ppb_rounded = gas_round_to_resolution(gas.ppb);
+	gas.snapshot.resolution  = gas.resolution;
+	gas.snapshot.slope       = gas.slope;
+	gas.snapshot.adc_count   = gas.adc_count;
+	gas.snapshot.temperature = gas.temperature;
+	gas.snapshot.humidity    = gas.humidity;
+	gas.snapshot.type        = gas.type;
+
+	gas.snapshot.adc_update_time     = gas.adc_update_time;
+	gas.snapshot.hdc1080_update_time = gas.hdc1080_update_time;
+
+	__DMB();
+	gas.snapshot.sequence++;
+}
+
+// Never blocks the writer. Since gas task and communication run in the
+// same main loop the copy normally succeeds on the first try.
+void gas_snapshot_read(GasSnapshot *snapshot) {
+	uint32_t sequence;
+	do {
+		sequence = gas.snapshot.sequence;
+		__DMB();
+
+		memcpy(snapshot, (const GasSnapshot*)&gas.snapshot, sizeof(GasSnapshot));
+
+		__DMB();
+	} while((sequence & 1) || (sequence != gas.snapshot.sequence));
+}
+
+// Time between two ADC counts in ms
+uint32_t gas_get_sample_period(void) {
+	if(gas.low_power_interval != 0) {
+		return gas.low_power_interval;
+	}
+
+	return MCP3423_TIME_BETWEEN_MEASUREMENTS;
+}
 
-	const double na               = ((double)(gas.adc_count - gas.adc_count_zero))/GAS_ADC_18BIT_MAX * 2.048/rgain * 1E9;
-	const double zero_compensated = na -  (zero *       (temperature - GAS_TEMPERATURE_THRESHOLD_ZERO));
-	const double span_compensated = 1.0 - (span/100.0 * (temperature - GAS_TEMPERATURE_THRESHOLD_SPAN));
+// Time between two temperature/humidity measurements in ms
+uint32_t gas_get_hdc1080_period(void) {
+	if(gas.low_power_interval != 0) {
+		return gas.low_power_interval;
+	}
 
-	gas.ppb = zero_compensated * span_compensated / ((double)gas.na_per_ppm) * 1E5;
-	logd("Gas: PPT %d, PPB %d, PPM %d\n\r", (int)(gas.ppb*1000), (int)gas.ppb, (int)(gas.ppb/1000.0));
+	return HDC1080_TIME_BETWEEN_MEASUREMENTS;
 }
 
+// In low power mode the MCP3423 runs one conversion per interval and goes
+// to standby in between, the HDC1080 measures once per interval (it is in
+// sleep mode between measurements anyway). The LMP91000 stays biased, an
+// electrochemical cell needs minutes to hours to stabilize after the bias
+// was switched off.
+//
+// Estimated average current of the sensors (without MCU), from the
+// typical values in the datasheets (MCP3423 145uA during the 267ms
+// conversion/0.3uA standby, HDC1080 190uA during 14ms/0.1uA sleep,
+// LMP91000 10uA):
+//
+// | Interval   | MCP3423 | HDC1080 | LMP91000 | Sum     | Latency of a step |
+// |------------|---------|---------|----------|---------|-------------------|
+// | continuous | 145uA   | 2.7uA   | 10uA     | 158uA   | 0.3s to 0.7s      |
+// | 1s         | 39uA    | 2.7uA   | 10uA     | 52uA    | up to 1.3s        |
+// | 10s        | 4.2uA   | 0.4uA   | 10uA     | 15uA    | up to 10.3s       |
+// | 60s        | 0.9uA   | 0.1uA   | 10uA     | 11uA    | up to 60.3s       |
+//
+// The latency adds to the period of the values callback. The MCU sleeps
+// with WFI in between (see gas_idle), which removes the main loop activity
+// but not the base current of the XMC1302 (some mA in active mode), so for
+// battery operation the supply of the Brick dominates.
+static void gas_update_schedule(void) {
+	const uint32_t time = system_timer_get_ms();
+
+	if(gas.low_power_interval != 0) {
+		// The interval is at least as long as the default periods
+		scheduler_set_period(SCHEDULER_JOB_MCP3423,  gas.low_power_interval, time);
+		scheduler_set_period(SCHEDULER_JOB_HDC1080,  gas.low_power_interval, time);
+		scheduler_set_period(SCHEDULER_JOB_LMP91000, gas.low_power_interval, time);
+	} else {
+		scheduler_set_period(SCHEDULER_JOB_MCP3423,  gas_get_sample_period(),            time);
+		scheduler_set_period(SCHEDULER_JOB_HDC1080,  HDC1080_TIME_BETWEEN_MEASUREMENTS,  time);
+		scheduler_set_period(SCHEDULER_JOB_LMP91000, LMP91000_TIME_BETWEEN_MEASUREMENTS, time);
+	}
+
+	// Switch the MCP3423 between continuous and one-shot mode. The slope
+	// window can not mix samples with different time between them.
+	// A running diagnostic would measure the reconfiguration.
+	diagnostic_abort();
+
+	// The time between two updates may have become shorter
+	gas.watchdog_start = system_timer_get_ms();
+	mcp3423_task_init();
+	slope_reset();
+}
+
+// Complete processing of one ADC conversion. The host replay tool
+// (software/host/replay.c) calls this directly for recorded samples.
+void gas_process_sample(const int32_t adc_count) {
+	gas.adc_count = outlier_filter(adc_count);
+	capture_add_sample(gas.adc_count, gas.temperature, gas.humidity);
+
+	slope_add_sample(gas.adc_count);
+	gas_calculate_ppb();
+	baseline_add_sample(gas.adc_count - gas.adc_count_zero, gas.ppb_per_count, gas_get_sample_period());
+	gas_snapshot_publish();
+	exposure_add_sample(gas.ppb, system_timer_get_ms());
+}
 
 void gas_task_tick(void) {
 	coop_task_sleep_ms(HDC1080_POWERUP_TIME);
@@ -231,11 +790,11 @@ void gas_task_tick(void) {
 
 	coop_task_sleep_ms(GAS_TIME_BETWEEN_INIT_AND_TICK);
 
-	uint32_t last_adc_count = 0;
+	scheduler_init(system_timer_get_ms());
+	gas_update_schedule();
 	while(true) {
-		lmp91000_task_tick();
-		hdc1080_task_tick();
-		mcp3423_task_tick();
+		gas.task_wakeup = false;
+		const uint32_t time_to_next_job = scheduler_tick(system_timer_get_ms());
 
 		if(gas.calibration_new) {
 			gas.calibration_new = false;
@@ -244,13 +803,55 @@ void gas_task_tick(void) {
 			// Read calibration again to use newly set values
 			// depending on different MAGIC numbers
 			gas_calibration_read();
+			gas_update_coefficients();
+
+			// The drift was learned relative to the old zero
+			baseline_reset();
 		}
 
-		if(last_adc_count != gas.adc_count) {
-			last_adc_count = gas.adc_count;
-			gas_calculate_ppb();
+		if(gas.low_power_new) {
+			gas.low_power_new = false;
+			gas_update_schedule();
 		}
 
+		if(gas.sensor_table_new) {
+			gas.sensor_table_new = false;
+			gas_sensor_table_write();
+
+			// Reconfigure the LMP91000, the TIA gain may have changed.
+			// A running diagnostic would measure the reconfiguration.
+			lmp91000_task_init();
+			diagnostic_abort();
+			gas_update_coefficients();
+		}
+
+		if(gas.configuration_save) {
+			gas.configuration_save = false;
+			gas_configuration_write();
+		}
+
+		if(gas.configuration_restore) {
+			gas.configuration_restore = false;
+			gas_configuration_read();
+		}
+
+		// Process every conversion exactly once, even if the same ADC count
+		// was measured twice
+		if(gas.adc_count_sample_new) {
+			gas.adc_count_sample_new = false;
+
+			// A sample replaced during a diagnostic run is not new data
+			const int32_t adc_count = diagnostic_add_sample(gas.adc_count_sample);
+			if(!diagnostic.replaced) {
+				gas.adc_update_time = system_timer_get_ms();
+			}
+
+			gas_process_sample(adc_count);
+		}
+
+		// gas_tick does not resume the task before the next job is due,
+		// unless it is woken up through gas.task_wakeup
+		gas.task_wake_time = system_timer_get_ms() + time_to_next_job;
 		coop_task_yield();
 	}
 }
@@ -276,7 +877,7 @@ void gas_init_i2c(void) {
 	gas.i2c_fifo.sda_fifo_size    = GAS_SDA_FIFO_SIZE;
 	gas.i2c_fifo.sda_fifo_pointer = GAS_SDA_FIFO_POINTER;
 
-	i2c_fifo_init(&gas.i2c_fifo);
+	gas_i2c_reset();
 }
 
 void gas_init(void) {
@@ -293,7 +894,21 @@ void gas_init(void) {
 	memset(&gas, 0, sizeof(Gas));
 
 	gas_calibration_read();
+	gas_sensor_table_read();
 	gas_init_i2c();
+	exposure_init(system_timer_get_ms());
+	slope_init();
+	outlier_init();
+	baseline_init();
+	diagnostic_init();
+
+	gas.slope_option     = GAS_THRESHOLD_OPTION_OFF;
+	gas.watchdog_timeout = GAS_WATCHDOG_TIMEOUT_DEFAULT;
+	gas.watchdog_start   = system_timer_get_ms();
+
+	// Overwrite the defaults above with the saved runtime configuration,
+	// so callbacks are active immediately after a power cycle.
+	gas_configuration_read();
 
 	gas.type = ((!XMC_GPIO_GetInput(GAS_TYPE0_PIN)) << 0) |
 	           ((!XMC_GPIO_GetInput(GAS_TYPE1_PIN)) << 1) |
@@ -304,10 +919,106 @@ void gas_init(void) {
 		logw("Unkown gas type: %d\n\r", gas.type);
 		gas.type = GAS_GAS_TYPE_CO;
 	}
+
+	gas_update_coefficients();
+
+	// Make gas type available before the first measurement
+	gas_snapshot_publish();
 	
 	coop_task_init(&gas_task, gas_task_tick);
 }
 
+// Called by the main loop. In low power mode the MCU sleeps until the next
+// interrupt if the gas task has nothing to do. The system timer interrupt
+// wakes it up every ms and SPITFP is interrupt driven, so the communication
+// with the Brick is delayed by at most 1ms.
+void gas_idle(void) {
+	if((gas.low_power_interval == 0) || gas.i2c_mutex || gas.task_wakeup) {
+		return;
+	}
+
+	if(((int32_t)(system_timer_get_ms() - gas.task_wake_time)) < 0) {
+		__WFI();
+	}
+}
+
+// The gas task stopped updating the measurements, e.g. an I2C transfer that
+// never finishes or an I2C mutex that was not released. The task can not be
+// resumed where it hangs, so the bus and the USIC are reset and the task
+// is started again from the beginning, which configures the LMP91000,
+// HDC1080 and MCP3423 again. Calibration, configuration and the state of
+// slope, baseline and exposure are kept.
+static void gas_watchdog_recover(const uint32_t adc_age, const uint32_t hdc1080_age) {
+	gas.watchdog_recovery_count++;
+	trace(TRACE_EVENT_WATCHDOG, adc_age, hdc1080_age);
+
+	gas_i2c_recover_bus();
+	gas.i2c_mutex       = false;
+	gas.i2c_irq_pending = false;
+	gas.task_wakeup     = true;
+	gas.watchdog_start  = system_timer_get_ms();
+
+	if(gas.watchdog_backoff < GAS_WATCHDOG_BACKOFF_MAX) {
+		gas.watchdog_backoff++;
+	}
+
+	coop_task_init(&gas_task, gas_task_tick);
+}
+
+static void gas_watchdog_tick(void) {
+	if(gas.watchdog_timeout == 0) {
+		return;
+	}
+
+	const uint32_t time        = system_timer_get_ms();
+	const uint32_t adc_age     = time - gas.adc_update_time;
+	const uint32_t hdc1080_age = time - gas.hdc1080_update_time;
+
+	if((adc_age <= gas_get_sample_period() + gas.watchdog_timeout) && (hdc1080_age <= gas_get_hdc1080_period() + gas.watchdog_timeout)) {
+		gas.watchdog_backoff = 0;
+		return;
+	}
+
+	// After a (re)start the task gets the whole timeout for the first update
+	const uint32_t start_age = time - gas.watchdog_start;
+	const uint32_t timeout   = gas.watchdog_timeout << gas.watchdog_backoff;
+
+	if(((adc_age     > gas_get_sample_period()  + timeout) && (start_age > gas_get_sample_period()  + timeout)) ||
+	   ((hdc1080_age > gas_get_hdc1080_period() + timeout) && (start_age > gas_get_hdc1080_period() + timeout))) {
+		gas_watchdog_recover(adc_age, hdc1080_age);
+	}
+}
+
 void gas_tick(void) {
+	gas_watchdog_tick();
+
+	gas.statistics_loop_count++;
+	if(system_timer_is_time_elapsed_ms(gas.statistics_start, 1000)) {
+		gas.loops_per_second        = gas.statistics_loop_count;
+		gas.resumes_per_second      = gas.statistics_resume_count;
+		gas.irqs_per_second         = gas.i2c_irq_count - gas.statistics_irq_count;
+		gas.statistics_loop_count   = 0;
+		gas.statistics_resume_count = 0;
+		gas.statistics_irq_count    = gas.i2c_irq_count;
+		gas.statistics_start        = system_timer_get_ms();
+	}
+
+	// While an I2C transfer is in flight the task is only resumed if the USIC
+	// signaled progress, so the main loop is free for bootloader and communication.
+	// As a fallback for events without interrupt the task is resumed after 1ms.
+	if(gas.i2c_mutex) {
+		if(!gas.i2c_irq_pending && !system_timer_is_time_elapsed_ms(gas.i2c_wait_start, 1)) {
+			return;
+		}
+	} else if(!gas.task_wakeup && (((int32_t)(system_timer_get_ms() - gas.task_wake_time)) < 0)) {
+		return;
+	}
+
+	gas.i2c_irq_pending = false;
+	gas.statistics_resume_count++;
 	coop_task_tick(&gas_task);
+
+	if(gas.i2c_mutex) {
+		gas.i2c_wait_start = system_timer_get_ms();
+	}
 }
\ No newline at end of file
@@ -24,10 +24,60 @@
 
 #include "bricklib2/hal/i2c_fifo/i2c_fifo.h"
 
+// Consistent set of measurement values of one measurement cycle. It is
+// published by the gas task once per cycle and copied by the communication
+// code with gas_snapshot_read. The sequence is odd while the snapshot is
+// written, a reader that sees an odd or changed sequence copies again.
+typedef struct {
+	uint32_t sequence;
+
+	double   ppb;
+	int32_t  ppb_rounded; // Rounded to resolution
+	uint32_t resolution;  // in ppb
+	int32_t  slope;
+	int32_t  adc_count;
+	int16_t  temperature;
+	uint16_t humidity;
+	uint8_t  type;
+	uint32_t adc_update_time;     // in ms
+	uint32_t hdc1080_update_time; // in ms
+} GasSnapshot;
+
+#define GAS_SENSOR_TABLE_NUM 9 // One table per gas type
+
+// Per gas type sensor table. The compiled in defaults can be overwritten
+// per type through the set_sensor_table function, they are stored in EEPROM.
+typedef struct {
+	uint8_t lmp91000[3];     // TIACN, REFCN, MODECN
+	int32_t compensation[4]; // Zero low/high in pA/°C, span low/high in %/°C*1000
+} GasSensorTable;
+
+// Low power mode: The sensors are only woken up once per interval, see
+// gas_update_schedule in gas.c for the current consumption per interval
+#define GAS_LOW_POWER_INTERVAL_MIN 1000    // in ms
+#define GAS_LOW_POWER_INTERVAL_MAX 3600000 // in ms
+
+// Stall watchdog: The gas task is started again if the ADC count or the
+// temperature/humidity were not updated for the timeout (on top of the
+// time between two updates). The timeout doubles with every recovery that
+// did not bring the updates back.
+#define GAS_WATCHDOG_TIMEOUT_MIN     5000    // in ms
+#define GAS_WATCHDOG_TIMEOUT_MAX     3600000 // in ms
+#define GAS_WATCHDOG_TIMEOUT_DEFAULT 10000   // in ms
+#define GAS_WATCHDOG_BACKOFF_MAX     6       // Timeout is at most doubled 6 times
+
 typedef struct {
 	I2CFifo i2c_fifo;
 	bool i2c_mutex;
 
+	volatile bool i2c_irq_pending;
+	volatile uint32_t i2c_irq_count;
+	uint32_t i2c_wait_start;
+
+	uint32_t i2c_error_count;
+	uint32_t i2c_bus_recovery_count;
+	uint32_t i2c_reinit_count;
+
 	uint8_t type;
 	int32_t na_per_ppm;
 
@@ -37,17 +87,42 @@ typedef struct {
 	int16_t temperature_offset;
 	int16_t humidity_offset;
 
+	// Last conversion result of the MCP3423, not yet processed
+	int32_t adc_count_sample;
+	bool adc_count_sample_new;
+
 	int32_t adc_count;
 	int32_t adc_count_zero;
 
 	uint8_t tia_gain;
 
 	double ppb;
-
+	int32_t slope; // in ppb per minute
+
+	GasSensorTable sensor_table[GAS_SENSOR_TABLE_NUM];
+	uint16_t sensor_table_custom; // Bit per gas type, set if table was uploaded
+	bool     sensor_table_new;
+
+	// Derived from sensor table and calibration by gas_update_coefficients.
+	// The temperature compensated coefficients are only updated if the
+	// temperature changes.
+	double   na_per_count;
+	double   ppb_per_na;
+	double   ppb_per_count;
+	double   ppb_zero_drift;
+	int16_t  coefficients_temperature;
+	bool     coefficients_temperature_valid;
+	uint32_t resolution; // in ppb, per gas type
 
 	uint32_t period;
 	bool value_has_to_change;
 
+	uint32_t slope_period;
+	bool     slope_value_has_to_change;
+	char     slope_option;
+	int32_t  slope_min;
+	int32_t  slope_max;
+
 	uint32_t calibration_adc_count_zero;
 	int16_t  calibration_temperature_zero;
 	int16_t  calibration_humidity_zero;
@@ -65,6 +140,34 @@ typedef struct {
 	int32_t  calibration_sensitivity;
 
 	bool     calibration_new;
+
+	bool     configuration_save;
+	bool     configuration_restore;
+
+	uint32_t task_wake_time;
+	bool     task_wakeup;
+
+	uint32_t low_power_interval; // in ms, 0 = continuous measurement
+	bool     low_power_new;
+
+	uint32_t adc_update_time;     // in ms, last processed ADC count
+	uint32_t hdc1080_update_time; // in ms, last temperature/humidity measurement
+
+	uint32_t watchdog_timeout;    // in ms, 0 = disabled
+	uint32_t watchdog_start;      // in ms, last (re)start of the measurement
+	uint8_t  watchdog_backoff;
+	uint32_t watchdog_recovery_count;
+
+	volatile GasSnapshot snapshot;
+
+	// Main loop statistics, counted over one second
+	uint32_t statistics_start;
+	uint32_t statistics_loop_count;
+	uint32_t statistics_resume_count;
+	uint32_t statistics_irq_count;
+	uint32_t loops_per_second;
+	uint32_t resumes_per_second;
+	uint32_t irqs_per_second;
 } Gas;
 
 extern Gas gas;
@@ -74,6 +177,21 @@ uint32_t gas_task_write_register(const uint8_t address, const I2C_FIFO_REG_TYPE
 uint32_t gas_task_read_direct(const uint8_t address, const uint32_t length, uint8_t *data, const bool restart);
 uint32_t gas_task_write_direct(const uint8_t address, const uint32_t length, const uint8_t *data, const bool send_stop);
 
+void gas_add_sample(const int32_t adc_count);
+void gas_snapshot_read(GasSnapshot *snapshot);
+
+void gas_calibration_read(void);
+void gas_calibration_write(void);
+void gas_sensor_table_default(const uint8_t type);
+void gas_sensor_table_read(void);
+void gas_sensor_table_write(void);
+void gas_update_coefficients(void);
+void gas_calculate_ppb(void);
+void gas_process_sample(const int32_t adc_count);
+
+uint32_t gas_get_sample_period(void);
+uint32_t gas_get_hdc1080_period(void);
+void gas_idle(void);
 void gas_init(void);
 void gas_tick(void);
 
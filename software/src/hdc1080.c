@@ -24,29 +24,43 @@
 #include "configs/config_hdc1080.h"
 
 #include "bricklib2/os/coop_task.h"
-#include "bricklib2/hal/i2c_fifo/i2c_fifo.h"
 #include "bricklib2/hal/system_timer/system_timer.h"
+#include "bricklib2/hal/i2c_fifo/i2c_fifo.h"
 #include "bricklib2/logging/logging.h"
 
 #include "gas.h"
+#include "trace.h"
 
-#define HDC1080_TIME_BETWEEN_MEASUREMENTS 1000 // in ms
+// Temperature in °C/100, see datasheet "Temperature Register"
+int16_t hdc1080_temperature_from_raw(const uint16_t raw) {
+	return ((int32_t)raw)*16500/(1 << 16) - 4000;
+}
+
+// Relative humidity in %RH/100, see datasheet "Humidity Register"
+uint16_t hdc1080_humidity_from_raw(const uint16_t raw) {
+	return ((int32_t)raw)*10000/(1 << 16);
+}
 
 void hdc1080_task_tick(void) {
-	static uint32_t last_time = 0;
-	if(system_timer_is_time_elapsed_ms(last_time, HDC1080_TIME_BETWEEN_MEASUREMENTS)) {
-		uint8_t data[4];
-		gas_task_write_register(HDC1080_I2C_ADDRESS, HDC1080_REG_TEMPERATURE, 0, (uint8_t*)data, true);
+	uint8_t data[4] = {0};
+	bool ok = gas_task_write_register(HDC1080_I2C_ADDRESS, HDC1080_REG_TEMPERATURE, 0, (uint8_t*)data, true) == 0;
+	if(ok) {
 		coop_task_sleep_ms(HDC1080_CONVERSION_TIME);
-		gas_task_read_direct(HDC1080_I2C_ADDRESS, 4, data, false);
+		ok = gas_task_read_direct(HDC1080_I2C_ADDRESS, 4, data, false) == 0;
+	}
 
-		gas.temperature  = ((int32_t)(data[1] | (data[0] << 8)))*16500/(1 << 16) - 4000;
+	if(!ok) {
+		// Keep the last temperature/humidity and make sure that the
+		// HDC1080 did not lose its configuration through the bus error
+		gas.i2c_reinit_count++;
+		hdc1080_task_init();
+	} else {
+		gas.temperature  = hdc1080_temperature_from_raw(data[1] | (data[0] << 8));
 		gas.temperature -= gas.temperature_offset;
-		gas.humidity     = ((int32_t)(data[3] | (data[2] << 8)))*10000/(1 << 16);
+		gas.humidity     = hdc1080_humidity_from_raw(data[3] | (data[2] << 8));
 		gas.humidity    -= gas.humidity_offset;
-		logd("HDC1080: Temperature %d, Humidity %d\n\r", gas.temperature, gas.humidity);
-
-		last_time = system_timer_get_ms();
+		gas.hdc1080_update_time = system_timer_get_ms();
+		trace(TRACE_EVENT_HDC1080, gas.temperature, gas.humidity);
 	}
 }
 
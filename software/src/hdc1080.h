@@ -22,9 +22,15 @@
 #ifndef HDC1080_H
 #define HDC1080_H
 
+#include <stdint.h>
+
+int16_t hdc1080_temperature_from_raw(const uint16_t raw);
+uint16_t hdc1080_humidity_from_raw(const uint16_t raw);
 void hdc1080_task_tick(void);
 void hdc1080_task_init(void);
 
+#define HDC1080_TIME_BETWEEN_MEASUREMENTS 1000 // in ms
+
 #define HDC1080_REG_TEMPERATURE     0x00
 #define HDC1080_REG_HUMIDITY        0x01
 #define HDC1080_REG_CONFIGURATION   0x02
@@ -25,15 +25,13 @@
 
 #include "bricklib2/os/coop_task.h"
 #include "bricklib2/hal/i2c_fifo/i2c_fifo.h"
-#include "bricklib2/hal/system_timer/system_timer.h"
 #include "bricklib2/logging/logging.h"
 
 #include "gas.h"
+#include "trace.h"
 
-#define LMP91000_TIME_BETWEEN_MEASUREMENTS 1000 // in ms
-
-// {TIACN, REFCN, MODECN}
-const uint8_t lmp91000_configuration[][3] = {
+// {TIACN, REFCN, MODECN}, can be overwritten per gas type with set_sensor_table
+const uint8_t lmp91000_default_configuration[][3] = {
 	{3,  145, 3}, // CO
 	{27, 147, 3}, // EtOH
 	{3,  144, 3}, // H2S
@@ -45,30 +43,112 @@ const uint8_t lmp91000_configuration[][3] = {
 	{3,  161, 3}, // O3/NO2
 };
 
+static bool lmp91000_initialized = false;
+
+// Rejects reserved bits and the bias and operation mode values that are
+// marked as not available in the datasheet. The temperature measurement
+// modes are rejected too: VOUT is the only output of the LMP91000 that the
+// MCP3423 measures, the temperature sensor would replace the gas signal.
+bool lmp91000_is_configuration_valid(const uint8_t tiacn, const uint8_t refcn, const uint8_t modecn) {
+	if(tiacn & LMP91000_TIACN_RESERVED_MASK) {
+		return false;
+	}
+
+	if((refcn & LMP91000_REFCN_BIAS_MASK) > LMP91000_REFCN_BIAS_MAX) {
+		return false;
+	}
+
+	const uint8_t op_mode = modecn & LMP91000_MODECN_OP_MODE_MASK;
+	if((modecn & LMP91000_MODECN_RESERVED_MASK) || (op_mode == 0b100) || (op_mode == 0b101) ||
+	   (op_mode == LMP91000_MODECN_OP_MODE_TEMPERATURE) || (op_mode == LMP91000_MODECN_OP_MODE_TEMPERATURE_TIA)) {
+		return false;
+	}
+
+	return true;
+}
+
+// Configuration the LMP91000 has to hold: TIACN, REFCN and MODECN
+static void lmp91000_get_configuration(uint8_t configuration[3]) {
+	configuration[0] = gas.sensor_table[gas.type].lmp91000[0];
+	configuration[1] = gas.sensor_table[gas.type].lmp91000[1];
+	configuration[2] = gas.sensor_table[gas.type].lmp91000[2];
+}
+
+// Reads the configuration back, returns 0 if all registers match
+static uint32_t lmp91000_verify(const uint8_t configuration[3]) {
+	const uint8_t regs[3] = {LMP91000_REG_TIACN, LMP91000_REG_REFCN, LMP91000_REG_MODECN};
+
+	uint32_t ret = 0;
+	for(uint8_t i = 0; (i < 3) && (ret == 0); i++) {
+		uint8_t data = 0;
+		ret = gas_task_read_register(LMP91000_I2C_ADDRESS, regs[i], 1, &data);
+		if((ret == 0) && (data != configuration[i])) {
+			trace(TRACE_EVENT_LMP91000_MISMATCH, regs[i], (data << 8) | configuration[i]);
+			ret = 1;
+		}
+	}
+
+	return ret;
+}
+
+// Returns false if a register does not hold the configuration anymore
+// (or could not be read), e.g. after a brown-out of the LMP91000
+bool lmp91000_check_configuration(void) {
+	uint8_t configuration[3];
+	lmp91000_get_configuration(configuration);
+
+	return lmp91000_verify(configuration) == 0;
+}
+
+// Moves the bias one step away from the configured bias (to the next
+// larger one, or the next smaller one at the maximum), or back
+uint32_t lmp91000_set_bias_step(const bool step) {
+	const uint8_t refcn = gas.sensor_table[gas.type].lmp91000[1];
+	const uint8_t bias  = refcn & LMP91000_REFCN_BIAS_MASK;
+
+	uint8_t value = refcn;
+	if(step) {
+		value = (refcn & ~LMP91000_REFCN_BIAS_MASK) | (bias < LMP91000_REFCN_BIAS_MAX ? bias + 1 : bias - 1);
+	}
+
+	return gas_task_write_register(LMP91000_I2C_ADDRESS, LMP91000_REG_REFCN, 1, &value, true);
+}
+
 void lmp91000_task_tick(void) {
+	// Retry the configuration until the LMP91000 is completely configured
+	if(!lmp91000_initialized) {
+		gas.i2c_reinit_count++;
+		lmp91000_task_init();
+	}
+
 #if LOGGING_LEVEL == LOGGING_DEBUG
-	static uint32_t last_time = 0;
-	if(system_timer_is_time_elapsed_ms(last_time, LMP91000_TIME_BETWEEN_MEASUREMENTS)) {
-		const uint8_t regs[5] = {LMP91000_REG_LOCK, LMP91000_REG_MODECN, LMP91000_REG_REFCN, LMP91000_REG_STATUS, LMP91000_REG_TIACN};
-
-		for(uint8_t i = 0; i < 5; i++) {
-			uint8_t data = 0;
-			gas_task_read_register(LMP91000_I2C_ADDRESS, regs[i], 1, &data);
-			logd("LMP91000: Register %x -> %x\n\r", regs[i], data);
-		}
+	const uint8_t regs[5] = {LMP91000_REG_LOCK, LMP91000_REG_MODECN, LMP91000_REG_REFCN, LMP91000_REG_STATUS, LMP91000_REG_TIACN};
 
-		last_time = system_timer_get_ms();
+	for(uint8_t i = 0; i < 5; i++) {
+		uint8_t data = 0;
+		gas_task_read_register(LMP91000_I2C_ADDRESS, regs[i], 1, &data);
+		trace(TRACE_EVENT_LMP91000_REGISTER, regs[i], data);
 	}
 #endif
 }
 
 void lmp91000_task_init(void) {
+	uint8_t configuration[3];
+	lmp91000_get_configuration(configuration);
+
 	uint8_t unlock = 0;
-	gas_task_write_register(LMP91000_I2C_ADDRESS, LMP91000_REG_LOCK,   1, &unlock,                              true);
+	uint32_t ret = 0;
+	ret |= gas_task_write_register(LMP91000_I2C_ADDRESS, LMP91000_REG_LOCK,   1, &unlock,           true);
+
+	ret |= gas_task_write_register(LMP91000_I2C_ADDRESS, LMP91000_REG_TIACN,  1, &configuration[0], true);
+	ret |= gas_task_write_register(LMP91000_I2C_ADDRESS, LMP91000_REG_REFCN,  1, &configuration[1], true);
+	ret |= gas_task_write_register(LMP91000_I2C_ADDRESS, LMP91000_REG_MODECN, 1, &configuration[2], true);
 
-	gas_task_write_register(LMP91000_I2C_ADDRESS, LMP91000_REG_TIACN,  1, &lmp91000_configuration[gas.type][0], true);
-	gas_task_write_register(LMP91000_I2C_ADDRESS, LMP91000_REG_REFCN,  1, &lmp91000_configuration[gas.type][1], true);
-	gas_task_write_register(LMP91000_I2C_ADDRESS, LMP91000_REG_MODECN, 1, &lmp91000_configuration[gas.type][2], true);
+	// Read the configuration back, a glitch during a write
+	// could otherwise leave the LMP91000 half-configured
+	if(ret == 0) {
+		ret = lmp91000_verify(configuration);
+	}
 
-	gas.tia_gain = (lmp91000_configuration[gas.type][0] & 0b00011100) >> 2;
-}
\ No newline at end of file
+	lmp91000_initialized = ret == 0;
+}
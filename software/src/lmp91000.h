@@ -22,13 +22,32 @@
 #ifndef LMP91000_H
 #define LMP91000_H
 
+#include <stdint.h>
+#include <stdbool.h>
+
+extern const uint8_t lmp91000_default_configuration[][3];
+
+bool lmp91000_is_configuration_valid(const uint8_t tiacn, const uint8_t refcn, const uint8_t modecn);
+bool lmp91000_check_configuration(void);
+uint32_t lmp91000_set_bias_step(const bool step);
 void lmp91000_task_tick(void);
 void lmp91000_task_init(void);
 
+#define LMP91000_TIME_BETWEEN_MEASUREMENTS 1000 // in ms
+
 #define LMP91000_REG_STATUS    0x00
 #define LMP91000_REG_LOCK      0x01
 #define LMP91000_REG_TIACN     0x10
 #define LMP91000_REG_REFCN     0x11
 #define LMP91000_REG_MODECN    0x12
 
+#define LMP91000_TIACN_RESERVED_MASK  0b11100000
+#define LMP91000_REFCN_BIAS_MASK      0b00001111
+#define LMP91000_REFCN_BIAS_MAX       13
+#define LMP91000_MODECN_RESERVED_MASK 0b01111000
+#define LMP91000_MODECN_OP_MODE_MASK  0b00000111
+
+#define LMP91000_MODECN_OP_MODE_TEMPERATURE     0b110 // Temperature sensor on VOUT, TIA off
+#define LMP91000_MODECN_OP_MODE_TEMPERATURE_TIA 0b111 // Temperature sensor on VOUT, TIA on
+
 #endif
\ No newline at end of file
@@ -41,5 +41,6 @@ int main(void) {
 		bootloader_tick();
 		communication_tick();
 		gas_tick();
+		gas_idle();
 	}
 }
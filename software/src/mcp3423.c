@@ -25,37 +25,67 @@
 
 #include "bricklib2/os/coop_task.h"
 #include "bricklib2/hal/i2c_fifo/i2c_fifo.h"
-#include "bricklib2/hal/system_timer/system_timer.h"
 #include "bricklib2/logging/logging.h"
 
 #include "gas.h"
+#include "trace.h"
 
 #define MCP3423_MAX_VALUE ((1 << 18)-1)
 
-// 4 SPS
-#define MCP3423_TIME_BETWEEN_MEASUREMENTS 250 // in ms
+// Configure ch0, gain 1x and 4 SPS
+#define MCP3423_CONFIGURATION (MCP3423_CONF_MSK_Gx1 | MCP3423_CONF_MSK_CH0 | MCP3423_CONF_MSK_SPS4)
 
-void mcp3423_task_tick(void) {
-	static uint32_t last_time = 0;
-	if(system_timer_is_time_elapsed_ms(last_time, MCP3423_TIME_BETWEEN_MEASUREMENTS)) {
-		uint8_t data[4];
+// Returns true if a new conversion result was read
+static bool mcp3423_read(void) {
+	uint8_t data[4];
+
+	if(gas_task_read_direct(MCP3423_I2C_ADDRESS, 4, data, false) != 0) {
+		// Keep the last ADC count and make sure that the MCP3423
+		// did not lose its configuration through the bus error
+		gas.i2c_reinit_count++;
+		mcp3423_task_init();
+		return false;
+	}
+
+	trace(TRACE_EVENT_MCP3423_RAW, (data[0] << 16) | (data[1] << 8) | data[2], data[3]);
+
+	// RDY is 0 only for a new conversion result
+	if(data[3] & MCP3423_CONF_MSK_RDY1) {
+		return false;
+	}
 
-		gas_task_read_direct(MCP3423_I2C_ADDRESS, 4, data, false);
-		logd("MCP3423: Raw %x %x %x %x\n\r", data[0], data[1], data[2], data[3]);
+	// 18 bits
+	const int32_t adc_count = MCP3423_MAX_VALUE - ((data[2] | (data[1] << 8) | ((data[0] & 0x03) << 16)));
+	gas_add_sample(adc_count);
 
-		if(!(data[3] & MCP3423_CONF_MSK_RDY1)) {
-			// 18 bits
-			gas.adc_count = MCP3423_MAX_VALUE - ((data[2] | (data[1] << 8) | ((data[0] & 0x03) << 16)));
+	trace(TRACE_EVENT_MCP3423_ADC_COUNT, adc_count, 0);
+	return true;
+}
+
+void mcp3423_task_tick(void) {
+	if(gas.low_power_interval == 0) {
+		mcp3423_read();
+		return;
+	}
 
-			logd("MCP3423: ADC Count %d\n\r", gas.adc_count);
-		}
+	// Low power mode: Start one conversion, the MCP3423 goes to standby
+	// after the conversion. The conversion time varies with the internal
+	// oscillator, so the result is polled a few times if it is late.
+	uint8_t configuration = MCP3423_CONFIGURATION | MCP3423_CONF_MSK_MODE_ONE_SHOT | MCP3423_CONF_MSK_RDY1;
+	if(gas_task_write_direct(MCP3423_I2C_ADDRESS, 1, &configuration, true) != 0) {
+		gas.i2c_reinit_count++;
+		mcp3423_task_init();
+		return;
+	}
 
-		last_time = system_timer_get_ms();
+	coop_task_sleep_ms(MCP3423_CONVERSION_TIME);
+	for(uint8_t i = 0; (i < MCP3423_ONE_SHOT_ATTEMPTS) && !mcp3423_read(); i++) {
+		coop_task_sleep_ms(MCP3423_ONE_SHOT_POLL_TIME);
 	}
 }
 
 void mcp3423_task_init(void) {
-	// Configure ch0, gain 1x and 4 SPS
-	uint8_t configuration = MCP3423_CONF_MSK_Gx1 | MCP3423_CONF_MSK_CH0 | MCP3423_CONF_MSK_MODE_CONT | MCP3423_CONF_MSK_SPS4 | MCP3423_CONF_MSK_RDY0;
+	// Continuous mode, or one-shot mode without starting a conversion (standby)
+	uint8_t configuration = MCP3423_CONFIGURATION | (gas.low_power_interval == 0 ? MCP3423_CONF_MSK_MODE_CONT : MCP3423_CONF_MSK_MODE_ONE_SHOT) | MCP3423_CONF_MSK_RDY0;
 	gas_task_write_direct(MCP3423_I2C_ADDRESS, 1, &configuration, true);
-}
\ No newline at end of file
+}
@@ -25,6 +25,14 @@
 void mcp3423_task_tick(void);
 void mcp3423_task_init(void);
 
+// 4 SPS
+#define MCP3423_TIME_BETWEEN_MEASUREMENTS 250 // in ms
+
+// One-shot conversion in low power mode, 3.75 SPS in 18 bit mode
+#define MCP3423_CONVERSION_TIME           267 // in ms
+#define MCP3423_ONE_SHOT_POLL_TIME        10  // in ms
+#define MCP3423_ONE_SHOT_ATTEMPTS         10
+
 #define MCP3423_CONF_MSK_Gx1 0x00
 #define MCP3423_CONF_MSK_Gx2 0x01
 #define MCP3423_CONF_MSK_Gx4 0x02
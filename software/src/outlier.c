@@ -0,0 +1,142 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * outlier.c: Median/MAD outlier rejection of the ADC count
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "outlier.h"
+
+#include <string.h>
+
+#include "trace.h"
+
+// Single sample spikes (ESD, bus glitches) are removed before the ADC count
+// is used for the concentration, the slope and the exposure. The samples of
+// the window are kept sorted, a new sample replaces the oldest one with one
+// pass of insertion sort. The median and the median absolute deviation (MAD)
+// are then read from the sorted array in O(window) without any allocation.
+//
+// A sample is an outlier if it is further away from the median than
+// threshold standard deviations, estimated as 1.4826*MAD. A real step in
+// the concentration becomes the median after half a window and is let
+// through from then on, since every sample (outliers included) is added
+// to the window.
+
+Outlier outlier;
+
+// Median of the absolute deviations from the median. Left of the median the
+// deviations increase with decreasing index, right of it with increasing
+// index. Merging both sides gives the deviations in ascending order.
+static int32_t outlier_get_mad(const int32_t median, const uint8_t count) {
+	int8_t  left      = count/2 - 1;
+	uint8_t right     = count/2;
+	int32_t deviation = 0;
+
+	for(uint8_t i = 0; i <= count/2; i++) {
+		if((left >= 0) && ((right >= count) || ((median - outlier.sorted[left]) <= (outlier.sorted[right] - median)))) {
+			deviation = median - outlier.sorted[left];
+			left--;
+		} else {
+			deviation = outlier.sorted[right] - median;
+			right++;
+		}
+	}
+
+	return deviation;
+}
+
+static void outlier_add_sample(const int32_t adc_count) {
+	uint8_t count = outlier.count;
+
+	// Remove oldest sample from the sorted samples
+	if(count == outlier.window) {
+		const int32_t oldest = outlier.samples[outlier.index];
+		uint8_t i = 0;
+		while(outlier.sorted[i] != oldest) {
+			i++;
+		}
+
+		for(; i < count - 1; i++) {
+			outlier.sorted[i] = outlier.sorted[i + 1];
+		}
+
+		count--;
+	}
+
+	// Insert new sample into the sorted samples
+	uint8_t i = count;
+	while((i > 0) && (outlier.sorted[i - 1] > adc_count)) {
+		outlier.sorted[i] = outlier.sorted[i - 1];
+		i--;
+	}
+
+	outlier.sorted[i]              = adc_count;
+	outlier.count                  = count + 1;
+	outlier.samples[outlier.index] = adc_count;
+	outlier.index                  = (outlier.index + 1) % outlier.window;
+}
+
+// Returns the ADC count that is used for the calculation of the concentration
+int32_t outlier_filter(const int32_t adc_count) {
+	if(outlier.mode == OUTLIER_MODE_OFF) {
+		return adc_count;
+	}
+
+	outlier_add_sample(adc_count);
+	if(outlier.count < OUTLIER_WINDOW_MIN) {
+		return adc_count;
+	}
+
+	const int32_t median    = outlier.sorted[outlier.count/2];
+	const int32_t mad       = outlier_get_mad(median, outlier.count);
+	const int32_t deviation = adc_count > median ? adc_count - median : median - adc_count;
+
+	// deviation > threshold/100 * 1.4826 * MAD, with a MAD of at least one count
+	// so that a perfectly flat signal does not turn every change into an outlier
+	const bool is_outlier = ((int64_t)deviation)*1000000 > ((int64_t)outlier.threshold)*14826*(mad > 1 ? mad : 1);
+	if(is_outlier) {
+		outlier.rejected_count++;
+		trace(TRACE_EVENT_OUTLIER, adc_count, median);
+	}
+
+	if((outlier.mode == OUTLIER_MODE_MEDIAN) || is_outlier) {
+		return median;
+	}
+
+	return adc_count;
+}
+
+void outlier_set_configuration(const uint8_t mode, const uint8_t window, const uint16_t threshold) {
+	if((mode != outlier.mode) || (window != outlier.window)) {
+		// Start with an empty window, the samples do not match the new
+		// window size and may be outdated if the filter was off
+		outlier.index = 0;
+		outlier.count = 0;
+	}
+
+	outlier.mode      = mode;
+	outlier.window    = window;
+	outlier.threshold = threshold;
+}
+
+void outlier_init(void) {
+	memset(&outlier, 0, sizeof(Outlier));
+	outlier.mode      = OUTLIER_MODE_OFF;
+	outlier.window    = OUTLIER_WINDOW_DEFAULT;
+	outlier.threshold = OUTLIER_THRESHOLD_DEFAULT;
+}
@@ -0,0 +1,58 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * outlier.h: Median/MAD outlier rejection of the ADC count
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef OUTLIER_H
+#define OUTLIER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define OUTLIER_MODE_OFF    0 // ADC count is used as is
+#define OUTLIER_MODE_MEDIAN 1 // Running median of the window is used
+#define OUTLIER_MODE_MAD    2 // ADC count is replaced by the median if it is an outlier
+
+#define OUTLIER_WINDOW_MIN     3 // Has to be odd
+#define OUTLIER_WINDOW_MAX     9 // Has to be odd
+#define OUTLIER_WINDOW_DEFAULT 5
+
+#define OUTLIER_THRESHOLD_MIN     100 // in standard deviations/100
+#define OUTLIER_THRESHOLD_DEFAULT 500
+
+typedef struct {
+	int32_t samples[OUTLIER_WINDOW_MAX]; // In order of arrival (ring buffer)
+	int32_t sorted[OUTLIER_WINDOW_MAX];  // Same samples in ascending order
+	uint8_t index;
+	uint8_t count;
+
+	uint8_t  mode;
+	uint8_t  window;
+	uint16_t threshold; // in standard deviations/100
+
+	uint32_t rejected_count;
+} Outlier;
+
+extern Outlier outlier;
+
+int32_t outlier_filter(const int32_t adc_count);
+void outlier_set_configuration(const uint8_t mode, const uint8_t window, const uint16_t threshold);
+void outlier_init(void);
+
+#endif
@@ -0,0 +1,102 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * scheduler.c: Deadline ordered periodic jobs of the sensor drivers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "scheduler.h"
+
+#include <string.h>
+
+#include "lmp91000.h"
+#include "hdc1080.h"
+#include "mcp3423.h"
+
+// All periodic bus accesses of the sensor drivers are jobs in one table.
+// Each pass of the gas task runs at most the one job with the earliest
+// deadline, so accesses to different chips never pile up in the same pass.
+// The phases spread the jobs with equal periods over time.
+
+#define SCHEDULER_PHASE_MCP3423  0   // in ms
+#define SCHEDULER_PHASE_HDC1080  100 // in ms
+#define SCHEDULER_PHASE_LMP91000 175 // in ms
+
+Scheduler scheduler;
+
+static bool scheduler_is_before(const uint32_t a, const uint32_t b) {
+	return ((int32_t)(a - b)) < 0;
+}
+
+// Runs the job with the earliest deadline if it is due.
+// Returns the time in ms until the next deadline.
+uint32_t scheduler_tick(const uint32_t time) {
+	SchedulerJob *next = &scheduler.jobs[0];
+	for(uint8_t i = 1; i < SCHEDULER_JOB_NUM; i++) {
+		if(scheduler_is_before(scheduler.jobs[i].next_time, next->next_time)) {
+			next = &scheduler.jobs[i];
+		}
+	}
+
+	if(!scheduler_is_before(time, next->next_time)) {
+		next->function();
+
+		// Keep the phase. If the job was delayed by more than one
+		// period (e.g. bus recovery), continue from now on.
+		next->next_time += next->period;
+		if(scheduler_is_before(next->next_time, time)) {
+			next->next_time = time + next->period;
+		}
+
+		return 0;
+	}
+
+	return next->next_time - time;
+}
+
+// Next run on the grid start_time + phase + n*period after now
+static void scheduler_align(SchedulerJob *job, const uint32_t time) {
+	const uint32_t first_time = scheduler.start_time + job->phase;
+	if(scheduler_is_before(time, first_time)) {
+		job->next_time = first_time;
+	} else {
+		job->next_time = time + job->period - ((time - first_time) % job->period);
+	}
+}
+
+void scheduler_set_period(const SchedulerJobID id, const uint32_t period, const uint32_t time) {
+	if(period == 0) {
+		return;
+	}
+
+	scheduler.jobs[id].period = period;
+	scheduler_align(&scheduler.jobs[id], time);
+}
+
+void scheduler_set_phase(const SchedulerJobID id, const uint32_t phase, const uint32_t time) {
+	scheduler.jobs[id].phase = phase;
+	scheduler_align(&scheduler.jobs[id], time);
+}
+
+void scheduler_init(const uint32_t time) {
+	memset(&scheduler, 0, sizeof(Scheduler));
+	scheduler.start_time = time;
+
+	scheduler.jobs[SCHEDULER_JOB_MCP3423]  = (SchedulerJob){mcp3423_task_tick,  MCP3423_TIME_BETWEEN_MEASUREMENTS,  SCHEDULER_PHASE_MCP3423,  time + SCHEDULER_PHASE_MCP3423};
+	scheduler.jobs[SCHEDULER_JOB_HDC1080]  = (SchedulerJob){hdc1080_task_tick,  HDC1080_TIME_BETWEEN_MEASUREMENTS,  SCHEDULER_PHASE_HDC1080,  time + SCHEDULER_PHASE_HDC1080};
+	scheduler.jobs[SCHEDULER_JOB_LMP91000] = (SchedulerJob){lmp91000_task_tick, LMP91000_TIME_BETWEEN_MEASUREMENTS, SCHEDULER_PHASE_LMP91000, time + SCHEDULER_PHASE_LMP91000};
+}
@@ -0,0 +1,54 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * scheduler.h: Deadline ordered periodic jobs of the sensor drivers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+	SCHEDULER_JOB_MCP3423 = 0,
+	SCHEDULER_JOB_HDC1080,
+	SCHEDULER_JOB_LMP91000,
+	SCHEDULER_JOB_NUM
+} SchedulerJobID;
+
+typedef struct {
+	void (*function)(void);
+	uint32_t period;    // in ms
+	uint32_t phase;     // in ms, offset of the first run relative to the start time
+	uint32_t next_time; // deadline of the next run
+} SchedulerJob;
+
+typedef struct {
+	SchedulerJob jobs[SCHEDULER_JOB_NUM];
+	uint32_t start_time;
+} Scheduler;
+
+extern Scheduler scheduler;
+
+uint32_t scheduler_tick(const uint32_t time);
+void scheduler_set_period(const SchedulerJobID id, const uint32_t period, const uint32_t time);
+void scheduler_set_phase(const SchedulerJobID id, const uint32_t phase, const uint32_t time);
+void scheduler_init(const uint32_t time);
+
+#endif
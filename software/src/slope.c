@@ -0,0 +1,83 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * slope.c: Least-squares slope estimation of the ADC count
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "slope.h"
+
+#include <string.h>
+
+// The slope is the least-squares fit of a line through the last
+// window samples. Sum of y and sum of x*y are updated in constant time
+// for each new sample, the sums of x and x*x only depend on the number of
+// samples in the window.
+
+Slope slope;
+
+void slope_add_sample(const int32_t adc_count) {
+	if(slope.count < slope.window) {
+		slope.sum_y  += adc_count;
+		slope.sum_xy += ((int64_t)slope.count)*adc_count;
+		slope.count++;
+	} else {
+		// Remove oldest sample and shift x of all remaining samples by one
+		const int32_t oldest = slope.samples[slope.index];
+		slope.sum_xy = slope.sum_xy - (slope.sum_y - oldest) + ((int64_t)(slope.window - 1))*adc_count;
+		slope.sum_y  = slope.sum_y - oldest + adc_count;
+	}
+
+	slope.samples[slope.index] = adc_count;
+	slope.index = (slope.index + 1) % slope.window;
+}
+
+double slope_get_counts_per_sample(void) {
+	const int64_t n = slope.count;
+	if(n < SLOPE_WINDOW_MIN) {
+		return 0.0;
+	}
+
+	const int64_t sum_x       = n*(n-1)/2;
+	const int64_t numerator   = n*slope.sum_xy - sum_x*slope.sum_y;
+	const int64_t denominator = n*n*(n*n - 1)/12; // n*sum(x*x) - sum(x)^2
+
+	return ((double)numerator)/denominator;
+}
+
+void slope_set_window(const uint8_t window) {
+	if(window == slope.window) {
+		return;
+	}
+
+	// Start with an empty window, the samples in the ring
+	// buffer do not match the new window size anymore.
+	memset(&slope, 0, sizeof(Slope));
+	slope.window = window;
+}
+
+// Has to be called if the time between the samples changes
+void slope_reset(void) {
+	const uint8_t window = slope.window;
+	memset(&slope, 0, sizeof(Slope));
+	slope.window = window;
+}
+
+void slope_init(void) {
+	memset(&slope, 0, sizeof(Slope));
+	slope.window = SLOPE_WINDOW_DEFAULT;
+}
@@ -0,0 +1,51 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * slope.h: Least-squares slope estimation of the ADC count
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef SLOPE_H
+#define SLOPE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SLOPE_WINDOW_MIN     2
+#define SLOPE_WINDOW_MAX     32
+#define SLOPE_WINDOW_DEFAULT 8
+
+typedef struct {
+	int32_t samples[SLOPE_WINDOW_MAX];
+	uint8_t index;
+	uint8_t count;
+	uint8_t window;
+
+	// Sum of y and sum of x*y with x = 0 for the oldest sample in the window
+	int64_t sum_y;
+	int64_t sum_xy;
+} Slope;
+
+extern Slope slope;
+
+void slope_add_sample(const int32_t adc_count);
+double slope_get_counts_per_sample(void);
+void slope_set_window(const uint8_t window);
+void slope_reset(void);
+void slope_init(void);
+
+#endif
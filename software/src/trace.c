@@ -0,0 +1,70 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * trace.c: Compact binary trace ring buffer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "trace.h"
+
+#include <string.h>
+
+#include "bricklib2/hal/system_timer/system_timer.h"
+
+// Formatted logging over the bit-banged UART blocks for the whole string
+// and changes the timing of the measurement. Trace events are only copied
+// into a ring buffer and read on demand through the read_trace function.
+// If the buffer is full the oldest event is overwritten.
+
+#ifdef TRACE_ENABLE
+static Trace trace_buffer;
+
+void trace(const uint8_t id, const int32_t arg0, const int32_t arg1) {
+	if((uint8_t)(trace_buffer.head - trace_buffer.tail) >= TRACE_BUFFER_SIZE) {
+		trace_buffer.tail++;
+		trace_buffer.lost++;
+	}
+
+	TraceEvent *event = &trace_buffer.events[trace_buffer.head & TRACE_BUFFER_MASK];
+	event->time = system_timer_get_ms();
+	event->id   = id;
+	event->arg0 = arg0;
+	event->arg1 = arg1;
+
+	trace_buffer.head++;
+}
+
+// Copies up to max_count events into data, which does not have to be aligned
+uint8_t trace_read(uint8_t *data, const uint8_t max_count, uint16_t *lost) {
+	uint8_t count = 0;
+	while((count < max_count) && (trace_buffer.tail != trace_buffer.head)) {
+		memcpy(&data[count*sizeof(TraceEvent)], &trace_buffer.events[trace_buffer.tail & TRACE_BUFFER_MASK], sizeof(TraceEvent));
+		trace_buffer.tail++;
+		count++;
+	}
+
+	*lost = trace_buffer.lost;
+	trace_buffer.lost = 0;
+
+	return count;
+}
+#else
+uint8_t trace_read(uint8_t *data, const uint8_t max_count, uint16_t *lost) {
+	*lost = 0;
+	return 0;
+}
+#endif
@@ -0,0 +1,67 @@
+/* gas-bricklet
+ * Copyright (C) 2019 Olaf Lüke <olaf@tinkerforge.com>
+ *
+ * trace.h: Compact binary trace ring buffer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "configs/config_trace.h"
+
+// The event IDs and argument meanings are decoded on the host by tests/trace.py
+#define TRACE_EVENT_MCP3423_RAW           1 // arg0: data[0..2], arg1: data[3]
+#define TRACE_EVENT_MCP3423_ADC_COUNT     2 // arg0: ADC count
+#define TRACE_EVENT_HDC1080               3 // arg0: temperature, arg1: humidity
+#define TRACE_EVENT_GAS_CONCENTRATION     4 // arg0: concentration in ppt, arg1: slope in ppb/min
+#define TRACE_EVENT_LMP91000_REGISTER     5 // arg0: register, arg1: value
+#define TRACE_EVENT_LMP91000_MISMATCH     6 // arg0: register, arg1: value << 8 | expected value
+#define TRACE_EVENT_I2C_ERROR             7 // arg0: i2c_fifo status, arg1: address << 8 | attempt
+#define TRACE_EVENT_OUTLIER               9 // arg0: rejected ADC count, arg1: median
+#define TRACE_EVENT_BASELINE             10 // arg0: quiet block mean, arg1: offset, both in ADC counts*256
+#define TRACE_EVENT_DIAGNOSTIC           12 // arg0: status, arg1: bias step response in ADC counts
+#define TRACE_EVENT_WATCHDOG             13 // arg0: ADC count age, arg1: temperature/humidity age, both in ms
+
+// 12 bytes without padding, copied as is (little endian) into the read_trace response
+typedef struct {
+	uint16_t time; // lower 16 bit of system time in ms
+	uint8_t  id;
+	uint8_t  reserved;
+	int32_t  arg0;
+	int32_t  arg1;
+} TraceEvent;
+
+typedef struct {
+	TraceEvent events[TRACE_BUFFER_SIZE];
+	uint8_t  head;
+	uint8_t  tail;
+	uint16_t lost; // Events that were overwritten before they were read
+} Trace;
+
+#ifdef TRACE_ENABLE
+void trace(const uint8_t id, const int32_t arg0, const int32_t arg1);
+#else
+#define trace(id, arg0, arg1)
+#endif
+
+uint8_t trace_read(uint8_t *data, const uint8_t max_count, uint16_t *lost);
+
+#endif
@@ -3,25 +3,203 @@
 
 HOST = "localhost"
 PORT = 4223
-UID = "XYZ" 
+UIDS = ["XYZ"] # All Gas Bricklets that are calibrated at the same time
+PPM_SPAN = 100 # Concentration of the span gas in ppm
+BATCH_SAMPLES = 8 # Samples per capture on the Bricklet, 2 s with 4 SPS
+MIN_BATCHES = 5 # Least number of batches per calibration point
+WINDOW_BATCHES = 30 # Only the most recent batches are used, older ones are still settling
+TOLERANCE = 0.5 # Max. half width of the 95% confidence interval of the mean in ADC counts
+SPAN_TOLERANCE = 0.002 # Same for the span point, relative to the difference between span and zero
+MIN_SPAN = 50 # Min. difference between span and zero in ADC counts
+MAX_TIME = 600 # Seconds per calibration point until a unit is given up
+EMULATOR = False # Apply the gases through emulator.py instead of asking the operator
+
+import time
+import math
 
 from tinkerforge.ip_connection import IPConnection
 from tinkerforge.bricklet_gas import BrickletGas
 
+import emulator
+
+# Calibrates zero and span of a batch of Gas Bricklets. For each calibration
+# point the operator applies the gas to all units, the tool then runs short
+# captures on all units in parallel. The Bricklet averages BATCH_SAMPLES
+# samples per capture, the tool treats the batch means as independent
+# samples and stops as soon as the 95% confidence interval of their mean
+# is narrower than +-TOLERANCE counts (zero) or +-SPAN_TOLERANCE of the
+# span signal, whichever is larger (span). Batch means are used instead of the
+# single samples, since successive samples are correlated by sensor noise
+# and the standard error of single samples would be too optimistic.
+#
+# A unit that is still settling after the gas change has a trend in its
+# batch means. A point is only accepted if the means of the older and the
+# newer half of the window agree within the tolerance or within their noise.
+# If they don't, the older half is dropped, so the settling batches don't
+# hold back the convergence until they leave the window.
+#
+# The sensitivity follows from the change of the sensor current between
+# zero and span, the compensation and offset values of the current
+# calibration are kept. The current of a capture includes the zero offset
+# of the sensor and the ADC, so only the difference between the two points
+# is used.
+#
+# With EMULATOR = True the tool runs against emulator.py and applies zero
+# and span gas itself:
+#
+#   python emulator.py --devices 4 &
+#   python calibration.py
+
+# Two-sided 95% quantiles of Student's t distribution for 1 to 30 degrees
+# of freedom, the normal quantile is used above
+T_95 = [12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042]
+
+def t_95(degrees_of_freedom):
+    if degrees_of_freedom <= len(T_95):
+        return T_95[degrees_of_freedom - 1]
+
+    return 1.96
+
+def mean(values):
+    return sum(values) / float(len(values))
+
+class Point:
+    def __init__(self, uid, zero=None):
+        self.uid = uid
+        self.zero = zero # Zero point, if this is the span point
+        self.batches = [] # (adc count mean, current, temperature, humidity)
+        self.converged = False
+        self.half_width = float('inf')
+        self.trend = float('inf')
+
+    def add(self, capture):
+        self.batches.append((capture.adc_count_mean / 100.0, capture.current, capture.temperature, capture.humidity))
+        self.batches = self.batches[-WINDOW_BATCHES:]
+
+        if len(self.batches) < MIN_BATCHES:
+            return
+
+        counts = [batch[0] for batch in self.batches]
+        m = mean(counts)
+        tolerance = TOLERANCE
+
+        if self.zero is not None:
+            tolerance = max(tolerance, SPAN_TOLERANCE * abs(m - self.zero.adc_count()))
+
+        variance = sum([(count - m) ** 2 for count in counts]) / (len(counts) - 1)
+        self.half_width = t_95(len(counts) - 1) * math.sqrt(variance / len(counts))
+
+        # Difference between the older and the newer half of the window. A
+        # difference within the noise of the two means is no trend
+        half = len(counts) // 2
+        self.trend = abs(mean(counts[half:]) - mean(counts[:half]))
+        trend_noise = t_95(len(counts) - 2) * math.sqrt(variance / half + variance / (len(counts) - half))
+        settled = self.trend <= max(tolerance, trend_noise)
+        self.converged = self.half_width <= tolerance and settled
+
+        if not settled:
+            self.batches = self.batches[half:]
+
+    def adc_count(self):
+        return mean([batch[0] for batch in self.batches])
+
+    def current(self):
+        return mean([batch[1] for batch in self.batches])
+
+    def temperature(self):
+        return int(round(mean([batch[2] for batch in self.batches])))
+
+    def humidity(self):
+        return int(round(mean([batch[3] for batch in self.batches])))
+
+def capture_point(name, concentration, devices, zero=None):
+    if EMULATOR:
+        print("Applying {0}".format(name))
+
+        for uid in devices:
+            emulator.set_gas(devices[uid], concentration)
+    else:
+        input("Apply {0} to all units and press key when the gas flows\n".format(name)) # Use raw_input() in Python 2
+
+    points = dict((uid, Point(uid, zero[uid] if zero is not None else None)) for uid in devices)
+    start = time.time()
+
+    while time.time() - start < MAX_TIME:
+        running = [uid for uid in devices if not points[uid].converged]
+
+        if len(running) == 0:
+            break
+
+        for uid in running:
+            devices[uid].start_calibration_capture(BATCH_SAMPLES)
+
+        time.sleep(BATCH_SAMPLES / 4.0)
+
+        for uid in running:
+            while True:
+                capture = devices[uid].get_calibration_capture()
+
+                if capture.state == BrickletGas.CAPTURE_STATE_DONE:
+                    break
+
+                time.sleep(0.1)
+
+            points[uid].add(capture)
+
+        print(" {0:.0f} s: ".format(time.time() - start) +
+              ", ".join(["{0} {1:.2f}+-{2:.2f}{3}".format(uid, points[uid].adc_count(), points[uid].half_width,
+                                                         " ok" if points[uid].converged else "")
+                         for uid in running if len(points[uid].batches) >= MIN_BATCHES]))
+
+    for uid in sorted(points):
+        if not points[uid].converged:
+            print("{0}: {1} did not converge within {2} s (+-{3:.2f}, trend {4:.2f} counts)".format(
+                  uid, name, MAX_TIME, points[uid].half_width, points[uid].trend))
+
+    return points
+
 if __name__ == "__main__":
     ipcon = IPConnection() # Create IP connection
-    gas = BrickletGas(UID, ipcon) # Create device object
+    devices = dict((uid, BrickletGas(uid, ipcon)) for uid in UIDS) # Create device objects
 
     ipcon.connect(HOST, PORT) # Connect to brickd
     # Don't use device before ipcon is connected
 
-    cal = gas.get_calibration()
-    print("Calibration Before: " + str(cal))
+    start = time.time()
+    zero = capture_point("zero gas", 0, devices)
+    span = capture_point("span gas ({0} ppm)".format(PPM_SPAN), PPM_SPAN * 1000, devices, zero)
+
+    for uid in sorted(devices):
+        if not zero[uid].converged or not span[uid].converged:
+            print("{0}: not calibrated".format(uid))
+            continue
+
+        if abs(span[uid].adc_count() - zero[uid].adc_count()) < MIN_SPAN:
+            print("{0}: not calibrated, span is only {1:.1f} ADC counts above zero".format(uid, span[uid].adc_count() - zero[uid].adc_count()))
+            continue
+
+        # The concentration is calculated with 1E5/sensitivity ppb per nA,
+        # so the sensitivity is in nA/ppm*100
+        sensitivity = int(round((span[uid].current() - zero[uid].current()) / (10.0 * PPM_SPAN)))
+        cal = devices[uid].get_calibration()
+        cal = cal._replace(adc_count_zero=int(round(zero[uid].adc_count())),
+                           temperature_zero=zero[uid].temperature(),
+                           humidity_zero=zero[uid].humidity(),
+                           ppm_span=PPM_SPAN,
+                           adc_count_span=int(round(span[uid].adc_count())),
+                           temperature_span=span[uid].temperature(),
+                           humidity_span=span[uid].humidity(),
+                           sensitivity=sensitivity)
+
+        devices[uid].set_calibration(*cal)
+        print("{0}: {1}".format(uid, devices[uid].get_calibration()))
 
-    gas.set_calibration(107292, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 290)
+    print("Calibrated in {0:.0f} s".format(time.time() - start))
 
-    cal = gas.get_calibration()
-    print("Calibration After: " + str(cal))
+    if EMULATOR:
+        for uid in devices:
+            emulator.set_gas(devices[uid], -1)
 
-    raw_input("Press key to exit\n") # Use input() in Python 3
     ipcon.disconnect()
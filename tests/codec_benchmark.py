@@ -0,0 +1,94 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+UID = "XYZ"
+COUNT = 200000 # Packets per measurement
+
+import sys
+import time
+import struct
+import socket
+import threading
+
+# Measures the packets/s of the payload codecs and of the receive path of
+# the IPConnection. The receive path is fed with values callbacks by a local
+# server, so no Bricklet is needed. To get the numbers before a change, pass
+# the directory that contains the tinkerforge package of the old bindings:
+#
+#   python codec_benchmark.py [bindings directory]
+
+if len(sys.argv) > 1:
+    sys.path.insert(0, sys.argv[1])
+
+from tinkerforge.ip_connection import IPConnection, base58decode, pack_payload, unpack_payload
+from tinkerforge.bricklet_gas import BrickletGas
+
+FORMS = [("values", 'i h H B', (1234567, 2512, 4512, 3)),
+         ("values extended", 'i h H B I I I', (1234567, 2512, 4512, 3, 10, 180, 730)),
+         ("exposure limit", 'i i ! !', (1000, 2000, True, False)),
+         ("enumerate", '8s 8s c 3B 3B H B', ("XYZ", "0", 'a', (1, 0, 0), (2, 0, 14), 2124, 0))]
+
+def rate(count, duration):
+    return "{0:.0f} packets/s".format(count / duration)
+
+def benchmark_codecs():
+    for name, form, data in FORMS:
+        packet = struct.pack('<IBBBB', 1, 8, 7, 0, 0) + pack_payload(data, form)
+
+        start = time.time()
+        for i in range(COUNT):
+            pack_payload(data, form)
+        pack_duration = time.time() - start
+
+        start = time.time()
+        for i in range(COUNT):
+            unpack_payload(packet[8:], form)
+        unpack_duration = time.time() - start
+
+        print("{0} '{1}': pack {2}, unpack {3}".format(name, form, rate(COUNT, pack_duration), rate(COUNT, unpack_duration)))
+
+def serve_callbacks(server, count):
+    connection, address = server.accept()
+    packet = struct.pack('<IBBBB', base58decode(UID), 8 + 9, BrickletGas.CALLBACK_VALUES, 0, 0) + \
+             struct.pack('<ihHB', 1234567, 2512, 4512, 3)
+    chunk = packet * 1000
+
+    for i in range(count // 1000):
+        connection.sendall(chunk)
+
+    done.wait()
+    connection.close()
+
+def benchmark_receive():
+    server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server.bind(('localhost', 0))
+    server.listen(1)
+    thread = threading.Thread(target=serve_callbacks, args=(server, COUNT))
+    thread.daemon = True
+    thread.start()
+
+    received = [0]
+    def cb_values(concentration, temperature, humidity, sensor_type):
+        received[0] += 1
+        if received[0] == COUNT:
+            done.set()
+
+    ipcon = IPConnection()
+    gas = BrickletGas(UID, ipcon)
+    gas.register_callback(gas.CALLBACK_VALUES, cb_values)
+
+    start = time.time()
+    ipcon.connect('localhost', server.getsockname()[1])
+    done.wait(120)
+    duration = time.time() - start
+
+    ipcon.disconnect()
+    server.close()
+
+    print("values callback receive path: {0}".format(rate(received[0], duration)))
+
+if __name__ == "__main__":
+    done = threading.Event()
+
+    benchmark_codecs()
+    benchmark_receive()
@@ -0,0 +1,382 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+HOST = "localhost"
+PORT = 4223
+DEVICES = 8 # Emulated Gas Bricklets
+UID_BASE = 100000 # UIDs are UID_BASE, UID_BASE + 1, ... (base58 encoded)
+
+import sys
+import math
+import time
+import random
+import socket
+import argparse
+import threading
+
+try:
+    import queue # Python 3
+except ImportError:
+    import Queue as queue # Python 2
+
+from tinkerforge.ip_connection import IPConnection, HEADER_STRUCT, base58encode, \
+                                      get_uid_from_data, get_length_from_data, \
+                                      get_function_id_from_data, pack_payload, unpack_payload
+from tinkerforge.bricklet_gas import BrickletGas
+
+# Local stand-in for brickd with a number of emulated Gas Bricklets, to
+# test the bindings and host tools at scale without hardware:
+#
+#   python emulator.py [--devices N] [--port PORT] [--period MS] [--seed SEED]
+#
+# Every device produces a synthetic concentration stream (slow sine, random
+# walk and noise around a per sensor type level) and supports the values
+# callback with its configuration, get_values, get_values_extended,
+# get_adc_count, the calibration and calibration capture functions,
+# get_identity and enumerate. Other functions are answered with "not
+# supported". --period starts all devices with the values callback
+# enabled, as if the period was saved in their configuration. Callbacks are
+# sent to all clients, like brickd does. A callback that is due late is
+# still sent, so the emulator doesn't lose callbacks on its side when the
+# host can't keep up.
+#
+# A host tool can apply a constant test gas (zero or span gas) to a device
+# with set_gas, e.g. calibration.py with EMULATOR = True. The emulated
+# sensor follows a change of the gas with the time constant RESPONSE_TIME.
+
+TICK = 0.001 # Seconds, resolution of the callback scheduler
+
+ERROR_CODE_OK = 0
+ERROR_CODE_INVALID_PARAMETER = 1
+ERROR_CODE_NOT_SUPPORTED = 2
+
+# ADC count to sensor current as calculated by the firmware: 18 bit ADC with
+# 2.048 V reference at the 350 kOhm TIA gain
+ADC_18BIT_MAX = 262143
+TIA_GAIN = 350000
+NA_PER_COUNT = 2.048 / ADC_18BIT_MAX / TIA_GAIN * 1E9
+
+RESPONSE_TIME = 5.0 # Seconds, time constant of the emulated sensor response
+
+# Function only known to the emulator, applies a constant test gas
+# (concentration in ppb, -1 returns to the synthetic stream)
+FUNCTION_SET_GAS = 200
+
+def set_gas(device, concentration):
+    # Applies a test gas to an emulated Gas Bricklet, device is a BrickletGas
+    device.response_expected[FUNCTION_SET_GAS] = BrickletGas.RESPONSE_EXPECTED_TRUE
+    device.ipcon.send_request(device, FUNCTION_SET_GAS, (concentration,), 'i', '')
+
+class EmulatedGas:
+    def __init__(self, index, rng, period):
+        self.uid = UID_BASE + index
+        self.position = chr(ord('a') + index % 8)
+        self.sensor_type = index % 9
+        self.ambient_level = rng.choice([400, 1000, 5000, 20000, 100000]) # ppb
+        self.level = self.ambient_level
+        self.phase = rng.uniform(0, 2 * math.pi)
+        self.variation = 1.0 # Scales sine, random walk and noise, 0 for a constant gas
+        self.walk = 0.0
+        self.response = float(self.level) # Concentration seen by the sensor
+        self.last_sample = time.time()
+        self.rng = rng
+        self.adc_count_zero = rng.randint(1000, 5000)
+        self.counts_per_ppb = rng.uniform(0.02, 0.1)
+        self.adc_count = 0
+        self.calibration = (0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0)
+        self.capture = None # [state, sample_count, samples, sum, sum of squares, temperature sum, humidity sum]
+        self.values = self.sample()
+        self.period = period # ms, protected by server lock
+        self.value_has_to_change = False
+        self.next_callback = time.time() + period / 1000.0
+        self.last_callback_values = None
+
+    def sample(self):
+        t = time.time()
+        self.walk = max(-0.2, min(0.2, self.walk + self.rng.gauss(0, 0.002)))
+        target = self.level * (1.0 + self.variation * (0.1 * math.sin(2 * math.pi * t / 60.0 + self.phase) + self.walk))
+
+        # The sensor follows a change of the gas with a first order response
+        self.response += (target - self.response) * (1.0 - math.exp(-(t - self.last_sample) / RESPONSE_TIME))
+        self.last_sample = t
+        concentration = self.response + self.rng.gauss(0, self.variation * self.level * 0.005)
+        temperature = 2300 + int(50 * math.sin(2 * math.pi * t / 600.0 + self.phase))
+        humidity = 4500 + int(200 * math.sin(2 * math.pi * t / 900.0 + self.phase))
+
+        # The ADC count follows the concentration with a fixed zero and
+        # sensitivity per device, plus a few counts of noise
+        self.adc_count = int(round(self.adc_count_zero + concentration * self.counts_per_ppb + self.rng.gauss(0, 2)))
+
+        if self.capture is not None and self.capture[0] == BrickletGas.CAPTURE_STATE_RUNNING:
+            self.capture[2] += 1
+            self.capture[3] += self.adc_count
+            self.capture[4] += self.adc_count ** 2
+            self.capture[5] += temperature
+            self.capture[6] += humidity
+
+            if self.capture[2] >= self.capture[1]:
+                self.capture[0] = BrickletGas.CAPTURE_STATE_DONE
+
+        return (int(max(concentration, 0)), temperature, humidity, self.sensor_type)
+
+    def set_gas(self, concentration):
+        if concentration < 0:
+            self.level = self.ambient_level
+            self.variation = 1.0
+        else:
+            self.level = concentration
+            self.variation = 0.0
+
+    def get_calibration_capture(self):
+        if self.capture is None or self.capture[2] == 0:
+            return (BrickletGas.CAPTURE_STATE_IDLE if self.capture is None else self.capture[0], 0, 0, 0, 0, 0, 0)
+
+        state, sample_count, n, total, squares, temperature, humidity = self.capture
+        mean = float(total) / n
+        std_dev = math.sqrt(max(squares - n * mean * mean, 0) / (n - 1)) if n > 1 else 0.0
+
+        return (state, n, int(mean * 100), int(std_dev * 100), int(mean * NA_PER_COUNT * 1000),
+                temperature // n, humidity // n)
+
+    def handle(self, function_id, payload):
+        # Returns the error code and the response payload, which is None
+        # for setters
+        if function_id == BrickletGas.FUNCTION_GET_VALUES:
+            return ERROR_CODE_OK, pack_payload(self.values, 'i h H B')
+        elif function_id == BrickletGas.FUNCTION_GET_VALUES_EXTENDED:
+            age = int((time.time() - self.last_sample) * 1000)
+            return ERROR_CODE_OK, pack_payload(self.values + (1, age, age), 'i h H B I I I')
+        elif function_id == BrickletGas.FUNCTION_GET_ADC_COUNT:
+            return ERROR_CODE_OK, pack_payload((self.adc_count,), 'I')
+        elif function_id == BrickletGas.FUNCTION_SET_CALIBRATION:
+            self.calibration = tuple(unpack_payload(payload, 'I h h i i I I h h i i h h i'))
+            return ERROR_CODE_OK, None
+        elif function_id == BrickletGas.FUNCTION_GET_CALIBRATION:
+            return ERROR_CODE_OK, pack_payload(self.calibration, 'I h h i i I I h h i i h h i')
+        elif function_id == BrickletGas.FUNCTION_SET_VALUES_CALLBACK_CONFIGURATION:
+            self.period, self.value_has_to_change = unpack_payload(payload, 'I !')
+            self.next_callback = time.time() + self.period / 1000.0
+            self.last_callback_values = None
+            return ERROR_CODE_OK, None
+        elif function_id == BrickletGas.FUNCTION_GET_VALUES_CALLBACK_CONFIGURATION:
+            return ERROR_CODE_OK, pack_payload((self.period, self.value_has_to_change), 'I !')
+        elif function_id == BrickletGas.FUNCTION_START_CALIBRATION_CAPTURE:
+            sample_count = unpack_payload(payload, 'H')
+
+            if sample_count < 2 or sample_count > 14400:
+                return ERROR_CODE_INVALID_PARAMETER, None
+
+            self.capture = [BrickletGas.CAPTURE_STATE_RUNNING, sample_count, 0, 0, 0, 0, 0]
+            return ERROR_CODE_OK, None
+        elif function_id == BrickletGas.FUNCTION_GET_CALIBRATION_CAPTURE:
+            return ERROR_CODE_OK, pack_payload(self.get_calibration_capture(), 'B H i I i h H')
+        elif function_id == FUNCTION_SET_GAS:
+            self.set_gas(unpack_payload(payload, 'i'))
+            return ERROR_CODE_OK, None
+        elif function_id == BrickletGas.FUNCTION_GET_IDENTITY:
+            return ERROR_CODE_OK, pack_payload(self.identity(), '8s 8s c 3B 3B H')
+
+        return ERROR_CODE_NOT_SUPPORTED, None
+
+    def identity(self):
+        return (base58encode(self.uid), "0", self.position, (1, 0, 0), (2, 0, 0), BrickletGas.DEVICE_IDENTIFIER)
+
+    def due_callbacks(self, now):
+        # NOTE: assumes that server lock is locked
+        packets = []
+
+        if self.period == 0:
+            return packets
+
+        while self.next_callback <= now:
+            self.next_callback += self.period / 1000.0
+
+            if self.value_has_to_change and self.values == self.last_callback_values:
+                continue
+
+            self.last_callback_values = self.values
+            packets.append(create_packet(self.uid, BrickletGas.CALLBACK_VALUES, 0, pack_payload(self.values, 'i h H B')))
+
+        return packets
+
+def create_packet(uid, function_id, sequence_number_and_options, payload, error_code=0):
+    return HEADER_STRUCT.pack(uid, 8 + len(payload), function_id,
+                              sequence_number_and_options, error_code << 6) + payload
+
+class Client:
+    def __init__(self, server, sock):
+        self.server = server
+        self.sock = sock
+        self.outgoing = queue.Queue()
+        self.running = True
+
+    def send(self, data):
+        self.outgoing.put(data)
+
+    def writer(self):
+        while self.running:
+            data = [self.outgoing.get()]
+
+            # Send everything that is queued up with one call
+            try:
+                while True:
+                    data.append(self.outgoing.get_nowait())
+            except queue.Empty:
+                pass
+
+            if None in data:
+                break
+
+            try:
+                self.sock.sendall(b''.join(data))
+            except socket.error:
+                break
+
+        self.running = False
+
+    def reader(self):
+        pending = b''
+
+        while self.running:
+            try:
+                data = self.sock.recv(8192)
+            except socket.error:
+                break
+
+            if len(data) == 0:
+                break
+
+            pending += data
+
+            while len(pending) >= 8 and len(pending) >= get_length_from_data(pending):
+                length = get_length_from_data(pending)
+
+                if length < 8:
+                    # Invalid header, drop connection like brickd does
+                    self.running = False
+                    break
+
+                self.server.handle_request(self, pending[:length])
+                pending = pending[length:]
+
+        self.running = False
+        self.outgoing.put(None)
+        self.server.remove_client(self)
+        self.sock.close()
+
+class Server:
+    def __init__(self, devices, period, seed):
+        rng = random.Random(seed)
+        self.devices = [EmulatedGas(i, random.Random(rng.random()), period) for i in range(devices)]
+        self.devices_by_uid = dict((device.uid, device) for device in self.devices)
+        self.lock = threading.Lock() # Protects device state and clients
+        self.clients = []
+        self.callbacks_sent = 0
+
+    def add_client(self, client):
+        with self.lock:
+            self.clients.append(client)
+
+    def remove_client(self, client):
+        with self.lock:
+            if client in self.clients:
+                self.clients.remove(client)
+
+    def handle_request(self, client, request):
+        uid = get_uid_from_data(request)
+        function_id = get_function_id_from_data(request)
+        sequence_number_and_options = bytearray(request[6:7])[0]
+        response_expected = (sequence_number_and_options & 0x08) != 0
+
+        if function_id == IPConnection.FUNCTION_DISCONNECT_PROBE:
+            return
+
+        if uid == IPConnection.BROADCAST_UID and function_id == IPConnection.FUNCTION_ENUMERATE:
+            with self.lock:
+                for device in self.devices:
+                    client.send(create_packet(device.uid, IPConnection.CALLBACK_ENUMERATE, 0,
+                                              pack_payload(device.identity() + (IPConnection.ENUMERATION_TYPE_AVAILABLE,),
+                                                           '8s 8s c 3B 3B H B')))
+            return
+
+        device = self.devices_by_uid.get(uid)
+
+        if device is None:
+            # Unknown UIDs are not answered, like brickd does
+            return
+
+        with self.lock:
+            error_code, payload = device.handle(function_id, request[8:])
+
+        # Getters are always answered, errors and setters only if a
+        # response is expected
+        if response_expected or (error_code == ERROR_CODE_OK and payload is not None):
+            client.send(create_packet(uid, function_id, sequence_number_and_options, payload or b'', error_code))
+
+    def tick(self):
+        last_sample = 0
+
+        while True:
+            now = time.time()
+            packets = []
+
+            with self.lock:
+                # Values change with the 4 SPS of the real Bricklet
+                if now - last_sample >= 0.25:
+                    last_sample = now
+
+                    for device in self.devices:
+                        device.values = device.sample()
+
+                for device in self.devices:
+                    packets += device.due_callbacks(now)
+
+                if len(packets) > 0:
+                    data = b''.join(packets)
+                    self.callbacks_sent += len(packets)
+
+                    for client in self.clients:
+                        client.send(data)
+
+            time.sleep(TICK)
+
+    def serve(self, host, port):
+        listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        listener.bind((host, port))
+        listener.listen(5)
+
+        thread = threading.Thread(target=self.tick)
+        thread.daemon = True
+        thread.start()
+
+        while True:
+            sock, address = listener.accept()
+            sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            client = Client(self, sock)
+            self.add_client(client)
+
+            for target in [client.reader, client.writer]:
+                thread = threading.Thread(target=target)
+                thread.daemon = True
+                thread.start()
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Emulates Gas Bricklets behind a brickd')
+    parser.add_argument('--devices', type=int, default=DEVICES)
+    parser.add_argument('--host', default=HOST)
+    parser.add_argument('--port', type=int, default=PORT)
+    parser.add_argument('--period', type=int, default=0, help='initial values callback period in ms')
+    parser.add_argument('--seed', type=int, default=0)
+    args = parser.parse_args()
+
+    server = Server(args.devices, args.period, args.seed)
+
+    print("Emulating {0} Gas Bricklets on {1}:{2}: {3}".format(args.devices, args.host, args.port,
+          ", ".join([base58encode(device.uid) for device in server.devices])))
+    sys.stdout.flush()
+
+    try:
+        server.serve(args.host, args.port)
+    except KeyboardInterrupt:
+        print("{0} callbacks sent".format(server.callbacks_sent))
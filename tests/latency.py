@@ -0,0 +1,44 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+HOST = "localhost"
+PORT = 4223
+UID = "XYZ"
+COUNT = 1000
+
+import time
+
+from tinkerforge.ip_connection import IPConnection
+from tinkerforge.bricklet_gas import BrickletGas
+
+# Measures the request-response latency of get_values and prints the
+# main loop statistics of the Bricklet that were measured at the same time.
+
+def percentile(values, p):
+    return values[min(len(values) - 1, int(len(values) * p / 100.0))]
+
+if __name__ == "__main__":
+    ipcon = IPConnection() # Create IP connection
+    gas = BrickletGas(UID, ipcon) # Create device object
+
+    ipcon.connect(HOST, PORT) # Connect to brickd
+    # Don't use device before ipcon is connected
+
+    latencies = []
+    for i in range(COUNT):
+        start = time.time()
+        gas.get_values()
+        latencies.append((time.time() - start) * 1000.0)
+
+    latencies.sort()
+    print("get_values latency in ms ({0} requests):".format(COUNT))
+    print(" min {0:.2f}, p50 {1:.2f}, p99 {2:.2f}, max {3:.2f}".format(latencies[0], percentile(latencies, 50), percentile(latencies, 99), latencies[-1]))
+
+    statistics = gas.get_main_loop_statistics()
+    print("Main loop: " + str(statistics))
+
+    if statistics.loops_per_second > 0:
+        idle = 100.0 * (statistics.loops_per_second - statistics.task_resumes_per_second) / statistics.loops_per_second
+        print("Measurement task idle in {0:.1f}% of the main loop passes".format(idle))
+
+    ipcon.disconnect()
@@ -0,0 +1,133 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+HOST = "localhost"
+PORT = 4223
+DEVICE_COUNTS = [1, 2, 4, 8, 16, 32, 64] # Counts larger than the number of found Bricklets are skipped
+PERIOD = 10 # Values callback period in ms
+DURATION = 5.0 # Seconds per device count
+REQUEST_INTERVAL = 0.05 # Seconds between get_values requests during the run
+
+import time
+
+from tinkerforge.ip_connection import IPConnection
+from tinkerforge.bricklet_gas import BrickletGas
+
+# Measures callback throughput, callback loss and latency on the host while
+# the number of Gas Bricklets that send values callbacks grows. Meant to
+# run against emulator.py, but works with real Bricklets as well:
+#
+#   python emulator.py --devices 64 &
+#   python load_test.py
+#
+# Loss is counted from the callbacks that arrived compared to the ones that
+# were due in the run, and estimated from gaps of more than 1.5 periods
+# between two callbacks of a device. The arrival jitter is the deviation of
+# the time between two callbacks from the period. The request latency is
+# the round trip time of get_values while the callbacks are streaming.
+
+def percentile(values, p):
+    if len(values) == 0:
+        return float('nan')
+
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100.0))]
+
+def discover(ipcon):
+    uids = []
+
+    def cb_enumerate(uid, connected_uid, position, hardware_version, firmware_version,
+                     device_identifier, enumeration_type):
+        if device_identifier == BrickletGas.DEVICE_IDENTIFIER and \
+           enumeration_type != IPConnection.ENUMERATION_TYPE_DISCONNECTED and \
+           uid not in uids:
+            uids.append(uid)
+
+    ipcon.register_callback(IPConnection.CALLBACK_ENUMERATE, cb_enumerate)
+    ipcon.enumerate()
+    time.sleep(1.0) # Enumerate has no end marker, give all Bricklets time to answer
+
+    return sorted(uids)
+
+def run(devices, arrivals):
+    for gas in devices:
+        del arrivals[gas.uid][:]
+
+    start = time.time()
+    enabled = {}
+    disabled = {}
+
+    for gas in devices:
+        gas.set_values_callback_configuration(PERIOD, False)
+        enabled[gas.uid] = time.time()
+
+    latencies = []
+    i = 0
+
+    while time.time() - start < DURATION:
+        request_start = time.time()
+        devices[i % len(devices)].get_values()
+        latencies.append((time.time() - request_start) * 1000.0)
+        i += 1
+        time.sleep(REQUEST_INTERVAL)
+
+    for gas in devices:
+        gas.set_values_callback_configuration(0, False)
+        disabled[gas.uid] = time.time()
+
+    duration = time.time() - start
+    time.sleep(0.2 + 2 * PERIOD / 1000.0) # Let callbacks in flight arrive
+
+    received = 0
+    expected = 0
+    missed = 0
+    jitter = []
+
+    for gas in devices:
+        times = arrivals[gas.uid]
+        received += len(times)
+        expected += int((disabled[gas.uid] - enabled[gas.uid]) * 1000.0 / PERIOD)
+
+        for a, b in zip(times, times[1:]):
+            gap = (b - a) * 1000.0
+            jitter.append(abs(gap - PERIOD))
+
+            if gap > PERIOD * 1.5:
+                missed += int(round(gap / PERIOD)) - 1
+
+    loss = max(expected - received, 0) * 100.0 / max(expected, 1)
+
+    print("{0:7} {1:11.0f} {2:8.2f} {3:7} {4:10.2f} {5:10.2f} {6:9.2f} {7:9.2f}".format(
+          len(devices), received / duration, loss, missed,
+          percentile(jitter, 50), percentile(jitter, 99),
+          percentile(latencies, 50), percentile(latencies, 99)))
+
+if __name__ == "__main__":
+    ipcon = IPConnection() # Create IP connection
+    ipcon.connect(HOST, PORT) # Connect to brickd
+    # Don't use device before ipcon is connected
+
+    uids = discover(ipcon)
+    print("Found {0} Gas Bricklets, values callback period {1} ms, {2} s per run".format(len(uids), PERIOD, DURATION))
+
+    devices = [BrickletGas(uid, ipcon) for uid in uids] # Create device objects
+    arrivals = {}
+
+    for gas in devices:
+        arrivals[gas.uid] = []
+
+        def cb_values(concentration, temperature, humidity, sensor_type, times=arrivals[gas.uid]):
+            times.append(time.time())
+
+        gas.register_callback(gas.CALLBACK_VALUES, cb_values)
+
+    print("devices callbacks/s   loss %  missed  jitter p50 jitter p99   rtt p50   rtt p99")
+    print("                                             ms         ms        ms        ms")
+
+    for count in DEVICE_COUNTS:
+        if count > len(devices):
+            break
+
+        run(devices[:count], arrivals)
+
+    ipcon.disconnect()
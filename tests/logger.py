@@ -0,0 +1,249 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+HOST = "localhost"
+PORT = 4223
+UIDS = ["XYZ"] # All Gas Bricklets that are logged
+PERIOD = 100 # Values callback period in ms
+FILENAME = "gas.log"
+BUFFER_RECORDS = 4096 # Records per buffer
+BUFFERS = 8 # Buffers in memory at most
+FLUSH_INTERVAL = 0.5 # Seconds between writes
+FSYNC_INTERVAL = 5.0 # Seconds between fsyncs
+
+import os
+import sys
+import csv
+import time
+import struct
+import threading
+
+try:
+    import queue # Python 3
+except ImportError:
+    import Queue as queue # Python 2
+
+from tinkerforge.ip_connection import IPConnection, base58encode
+from tinkerforge.bricklet_gas import BrickletGas
+
+# Logs the values callbacks of many Bricklets into an append-only binary
+# file and exports it to CSV:
+#
+#   python logger.py [FILENAME]
+#   python logger.py export FILENAME > values.csv
+#
+# The file starts with a header, followed by fixed size records of host
+# time, UID and the callback values. The callbacks only pack the records
+# into a fixed pool of buffers, a writer thread writes full buffers (and
+# partially filled ones every FLUSH_INTERVAL) and fsyncs the file every
+# FSYNC_INTERVAL. If the writer falls behind and the pool runs empty, the
+# callbacks wait for it instead of dropping records, so memory stays
+# bounded. An incomplete last record after a crash is ignored.
+
+MAGIC = b"GASLOG"
+VERSION = 1
+HEADER = struct.Struct('<6sBB') # magic, version, record size
+RECORD = struct.Struct('<dIihHB') # time in s, UID, concentration, temperature, humidity, sensor type
+
+def check_header(filename, f):
+    data = f.read(HEADER.size)
+
+    if len(data) < HEADER.size or HEADER.unpack(data) != (MAGIC, VERSION, RECORD.size):
+        raise ValueError("{0} is not a version {1} gas log".format(filename, VERSION))
+
+class Logger:
+    def __init__(self, filename):
+        if os.path.exists(filename) and os.path.getsize(filename) > 0:
+            with open(filename, 'rb') as f:
+                check_header(filename, f)
+
+            # Cut off the tail of a record that was not completely written
+            # before the last session ended, so that new records stay aligned
+            size = os.path.getsize(filename)
+            tail = (size - HEADER.size) % RECORD.size
+
+            if tail > 0:
+                with open(filename, 'r+b') as f:
+                    f.truncate(size - tail)
+
+            self.f = open(filename, 'ab')
+        else:
+            self.f = open(filename, 'ab')
+            self.f.write(HEADER.pack(MAGIC, VERSION, RECORD.size))
+            self.f.flush()
+
+        self.lock = threading.Lock() # Protects current and used
+        self.free = queue.Queue()
+        self.full = queue.Queue() # (buffer, used), (None, 0) stops the writer
+
+        for i in range(BUFFERS):
+            self.free.put(bytearray(BUFFER_RECORDS * RECORD.size))
+
+        self.current = self.free.get()
+        self.used = 0
+        self.records = 0
+        self.stalls = 0
+        self.thread = threading.Thread(target=self.writer)
+        self.thread.daemon = True
+        self.thread.start()
+
+    def add(self, uid, concentration, temperature, humidity, sensor_type):
+        with self.lock:
+            RECORD.pack_into(self.current, self.used * RECORD.size,
+                             time.time(), uid, concentration, temperature, humidity, sensor_type)
+            self.used += 1
+            self.records += 1
+
+            if self.used < BUFFER_RECORDS:
+                return
+
+            self.full.put((self.current, self.used))
+            self.used = 0
+
+            try:
+                self.current = self.free.get_nowait()
+            except queue.Empty:
+                # Writer fell behind, wait for it instead of dropping records
+                self.stalls += 1
+                self.current = self.free.get()
+
+    def take_partial(self):
+        # Hands a partially filled buffer to the writer if one is free to
+        # replace it, otherwise it is picked up with the next full buffer
+        with self.lock:
+            if self.used == 0:
+                return None
+
+            try:
+                replacement = self.free.get_nowait()
+            except queue.Empty:
+                return None
+
+            item = (self.current, self.used)
+            self.current = replacement
+            self.used = 0
+
+            return item
+
+    def writer(self):
+        last_fsync = time.time()
+
+        while True:
+            try:
+                item = self.full.get(True, FLUSH_INTERVAL)
+            except queue.Empty:
+                item = self.take_partial()
+
+            if item is not None:
+                buf, used = item
+
+                if buf is None:
+                    break
+
+                self.f.write(memoryview(buf)[:used * RECORD.size])
+                self.f.flush()
+                self.free.put(buf)
+
+            if time.time() - last_fsync >= FSYNC_INTERVAL:
+                os.fsync(self.f.fileno())
+                last_fsync = time.time()
+
+        os.fsync(self.f.fileno())
+
+    def close(self):
+        # NOTE: assumes that no callbacks arrive anymore
+        if self.used > 0:
+            self.full.put((self.current, self.used))
+            self.used = 0
+
+        self.full.put((None, 0))
+        self.thread.join()
+        self.f.close()
+
+class Statistics:
+    # Counts callbacks per device and estimates missed callbacks from gaps
+    # between callbacks that are longer than 1.5 callback periods
+    def __init__(self):
+        self.count = 0
+        self.missed = 0
+        self.last = None
+
+    def add(self, now):
+        if self.last is not None:
+            gap = (now - self.last) * 1000.0
+
+            if gap > PERIOD * 1.5:
+                self.missed += int(round(gap / PERIOD)) - 1
+
+        self.count += 1
+        self.last = now
+
+def log(filename):
+    logger = Logger(filename)
+    ipcon = IPConnection() # Create IP connection
+    devices = [BrickletGas(uid, ipcon) for uid in UIDS] # Create device objects
+    statistics = {}
+
+    for uid_string, gas in zip(UIDS, devices):
+        stats = Statistics()
+        statistics[uid_string] = stats
+
+        def cb_values(concentration, temperature, humidity, sensor_type, uid=gas.uid, stats=stats):
+            logger.add(uid, concentration, temperature, humidity, sensor_type)
+            stats.add(time.time())
+
+        gas.register_callback(gas.CALLBACK_VALUES, cb_values)
+
+    def cb_connected(connect_reason):
+        # Configure the callbacks again after an auto reconnect
+        for gas in devices:
+            gas.set_values_callback_configuration(PERIOD, False)
+
+    ipcon.register_callback(IPConnection.CALLBACK_CONNECTED, cb_connected)
+    start = time.time()
+
+    try:
+        ipcon.connect(HOST, PORT) # Connect to brickd
+        # Don't use device before ipcon is connected
+
+        try:
+            input("Logging to {0}, press key to exit\n".format(filename)) # Use raw_input() in Python 2
+        except (KeyboardInterrupt, EOFError):
+            pass
+
+        for gas in devices:
+            gas.set_values_callback_configuration(0, False)
+
+        ipcon.disconnect()
+    finally:
+        logger.close()
+
+    duration = time.time() - start
+    print("{0} records in {1:.1f} s ({2:.0f} records/s), writer stalled {3} times".format(logger.records, duration, logger.records / duration, logger.stalls))
+
+    for uid_string in sorted(statistics):
+        stats = statistics[uid_string]
+        print("{0}: {1} callbacks, {2} missed".format(uid_string, stats.count, stats.missed))
+
+def export(filename, out):
+    with open(filename, 'rb') as f:
+        check_header(filename, f)
+
+        writer = csv.writer(out)
+        writer.writerow(["time", "uid", "concentration", "temperature", "humidity", "sensor_type"])
+
+        while True:
+            data = f.read(RECORD.size * BUFFER_RECORDS)
+
+            for offset in range(0, len(data) - RECORD.size + 1, RECORD.size):
+                t, uid, concentration, temperature, humidity, sensor_type = RECORD.unpack_from(data, offset)
+                writer.writerow(["{0:.3f}".format(t), base58encode(uid), concentration, temperature, humidity, sensor_type])
+
+            if len(data) < RECORD.size * BUFFER_RECORDS:
+                break
+
+if __name__ == "__main__":
+    if len(sys.argv) == 3 and sys.argv[1] == "export":
+        export(sys.argv[2], sys.stdout)
+    else:
+        log(sys.argv[1] if len(sys.argv) > 1 else FILENAME)
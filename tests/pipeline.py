@@ -0,0 +1,48 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+HOST = "localhost"
+PORT = 4223
+UIDS = ["XYZ"] # All Gas Bricklets that are polled
+ROUNDS = 100
+
+import time
+
+from tinkerforge.ip_connection import IPConnection
+from tinkerforge.bricklet_gas import BrickletGas
+
+# Polls get_values and get_adc_count of all Bricklets, once with one request
+# in flight and once pipelined with all requests of a round in flight, and
+# prints the achieved request rate of both.
+
+def poll_sync(devices):
+    for gas in devices:
+        gas.get_values()
+        gas.get_adc_count()
+
+def poll_pipelined(devices):
+    futures = []
+    for gas in devices:
+        futures.append(gas.get_values_async())
+        futures.append(gas.get_adc_count_async())
+
+    for future in futures:
+        future.result()
+
+if __name__ == "__main__":
+    ipcon = IPConnection() # Create IP connection
+    devices = [BrickletGas(uid, ipcon) for uid in UIDS] # Create device objects
+
+    ipcon.connect(HOST, PORT) # Connect to brickd
+    # Don't use device before ipcon is connected
+
+    for name, poll in [("sync", poll_sync), ("pipelined", poll_pipelined)]:
+        start = time.time()
+        for i in range(ROUNDS):
+            poll(devices)
+        duration = time.time() - start
+
+        requests = ROUNDS * len(devices) * 2
+        print("{0}: {1} requests in {2:.2f} s ({3:.0f} requests/s)".format(name, requests, duration, requests / duration))
+
+    ipcon.disconnect()
@@ -21,6 +21,22 @@ except ValueError:
 GetValues = namedtuple('Values', ['gas_concentration', 'temperature', 'humidity', 'gas_type'])
 GetCalibration = namedtuple('Calibration', ['adc_count_zero', 'temperature_zero', 'humidity_zero', 'compensation_zero_low', 'compensation_zero_high', 'ppm_span', 'adc_count_span', 'temperature_span', 'humidity_span', 'compensation_span_low', 'compensation_span_high', 'temperature_offset', 'humidity_offset', 'sensitivity'])
 GetValuesCallbackConfiguration = namedtuple('ValuesCallbackConfiguration', ['period', 'value_has_to_change'])
+GetExposure = namedtuple('Exposure', ['twa', 'stel', 'minutes'])
+GetExposureLimitConfiguration = namedtuple('ExposureLimitConfiguration', ['twa_limit', 'stel_limit'])
+GetConcentrationSlopeCallbackConfiguration = namedtuple('ConcentrationSlopeCallbackConfiguration', ['period', 'value_has_to_change', 'option', 'min', 'max'])
+GetI2CErrorCount = namedtuple('I2CErrorCount', ['error_count_transfer', 'error_count_bus_recovery', 'error_count_reinit'])
+GetMainLoopStatistics = namedtuple('MainLoopStatistics', ['loops_per_second', 'task_resumes_per_second', 'i2c_interrupts_per_second'])
+ReadTrace = namedtuple('ReadTrace', ['events_lost', 'events_length', 'events_data'])
+GetValuesExtended = namedtuple('ValuesExtended', ['gas_concentration', 'temperature', 'humidity', 'gas_type', 'resolution', 'gas_concentration_age', 'temperature_humidity_age'])
+GetSensorTable = namedtuple('SensorTable', ['tiacn', 'refcn', 'modecn', 'compensation_zero_low', 'compensation_zero_high', 'compensation_span_low', 'compensation_span_high', 'custom'])
+GetOutlierFilterConfiguration = namedtuple('OutlierFilterConfiguration', ['mode', 'window_size', 'threshold'])
+GetBaselineTrackingConfiguration = namedtuple('BaselineTrackingConfiguration', ['enable', 'time_constant', 'quiet_threshold', 'limit'])
+GetBaselineOffset = namedtuple('BaselineOffset', ['offset_adc_count', 'offset_ppb', 'quiet_minutes'])
+GetLowPowerConfiguration = namedtuple('LowPowerConfiguration', ['enable', 'interval'])
+GetCalibrationCapture = namedtuple('CalibrationCapture', ['state', 'sample_count', 'adc_count_mean', 'adc_count_std_dev', 'current', 'temperature', 'humidity'])
+GetDiagnosticConfiguration = namedtuple('DiagnosticConfiguration', ['interval', 'response_min'])
+GetDiagnosticStatus = namedtuple('DiagnosticStatus', ['status', 'response', 'run_count', 'register_error_count'])
+GetDataAge = namedtuple('DataAge', ['adc_count_age', 'temperature_humidity_age', 'recovery_count'])
 GetSPITFPErrorCount = namedtuple('SPITFPErrorCount', ['error_count_ack_checksum', 'error_count_message_checksum', 'error_count_frame', 'error_count_overflow'])
 GetIdentity = namedtuple('Identity', ['uid', 'connected_uid', 'position', 'hardware_version', 'firmware_version', 'device_identifier'])
 
@@ -34,6 +50,8 @@ class BrickletGas(Device):
     DEVICE_URL_PART = 'gas' # internal
 
     CALLBACK_VALUES = 7
+    CALLBACK_EXPOSURE_LIMIT = 11
+    CALLBACK_CONCENTRATION_SLOPE = 17
 
 
     FUNCTION_GET_VALUES = 1
@@ -42,6 +60,39 @@ class BrickletGas(Device):
     FUNCTION_GET_CALIBRATION = 4
     FUNCTION_SET_VALUES_CALLBACK_CONFIGURATION = 5
     FUNCTION_GET_VALUES_CALLBACK_CONFIGURATION = 6
+    FUNCTION_GET_EXPOSURE = 8
+    FUNCTION_SET_EXPOSURE_LIMIT_CONFIGURATION = 9
+    FUNCTION_GET_EXPOSURE_LIMIT_CONFIGURATION = 10
+    FUNCTION_GET_CONCENTRATION_SLOPE = 12
+    FUNCTION_SET_CONCENTRATION_SLOPE_CONFIGURATION = 13
+    FUNCTION_GET_CONCENTRATION_SLOPE_CONFIGURATION = 14
+    FUNCTION_SET_CONCENTRATION_SLOPE_CALLBACK_CONFIGURATION = 15
+    FUNCTION_GET_CONCENTRATION_SLOPE_CALLBACK_CONFIGURATION = 16
+    FUNCTION_SAVE_CONFIGURATION = 18
+    FUNCTION_RESTORE_CONFIGURATION = 19
+    FUNCTION_GET_I2C_ERROR_COUNT = 20
+    FUNCTION_GET_MAIN_LOOP_STATISTICS = 21
+    FUNCTION_READ_TRACE = 22
+    FUNCTION_SET_SENSOR_TABLE = 23
+    FUNCTION_GET_SENSOR_TABLE = 24
+    FUNCTION_RESET_SENSOR_TABLE = 25
+    FUNCTION_GET_VALUES_EXTENDED = 26
+    FUNCTION_SET_OUTLIER_FILTER_CONFIGURATION = 27
+    FUNCTION_GET_OUTLIER_FILTER_CONFIGURATION = 28
+    FUNCTION_GET_OUTLIER_FILTER_COUNT = 29
+    FUNCTION_SET_BASELINE_TRACKING_CONFIGURATION = 30
+    FUNCTION_GET_BASELINE_TRACKING_CONFIGURATION = 31
+    FUNCTION_GET_BASELINE_OFFSET = 32
+    FUNCTION_SET_LOW_POWER_CONFIGURATION = 33
+    FUNCTION_GET_LOW_POWER_CONFIGURATION = 34
+    FUNCTION_START_CALIBRATION_CAPTURE = 35
+    FUNCTION_GET_CALIBRATION_CAPTURE = 36
+    FUNCTION_SET_DIAGNOSTIC_CONFIGURATION = 40
+    FUNCTION_GET_DIAGNOSTIC_CONFIGURATION = 41
+    FUNCTION_GET_DIAGNOSTIC_STATUS = 42
+    FUNCTION_SET_WATCHDOG_CONFIGURATION = 43
+    FUNCTION_GET_WATCHDOG_CONFIGURATION = 44
+    FUNCTION_GET_DATA_AGE = 45
     FUNCTION_GET_SPITFP_ERROR_COUNT = 234
     FUNCTION_SET_BOOTLOADER_MODE = 235
     FUNCTION_GET_BOOTLOADER_MODE = 236
@@ -80,6 +131,18 @@ class BrickletGas(Device):
     BOOTLOADER_STATUS_ENTRY_FUNCTION_NOT_PRESENT = 3
     BOOTLOADER_STATUS_DEVICE_IDENTIFIER_INCORRECT = 4
     BOOTLOADER_STATUS_CRC_MISMATCH = 5
+    OUTLIER_FILTER_MODE_OFF = 0
+    OUTLIER_FILTER_MODE_MEDIAN = 1
+    OUTLIER_FILTER_MODE_MAD = 2
+    CAPTURE_STATE_IDLE = 0
+    CAPTURE_STATE_RUNNING = 1
+    CAPTURE_STATE_DONE = 2
+    DIAGNOSTIC_STATUS_NOT_RUN = 0
+    DIAGNOSTIC_STATUS_OK = 1
+    DIAGNOSTIC_STATUS_REGISTER_ERROR = 2
+    DIAGNOSTIC_STATUS_NO_RESPONSE = 3
+    DIAGNOSTIC_STATUS_SATURATED = 4
+    DIAGNOSTIC_STATUS_NOT_RECOVERED = 5
     STATUS_LED_CONFIG_OFF = 0
     STATUS_LED_CONFIG_ON = 1
     STATUS_LED_CONFIG_SHOW_HEARTBEAT = 2
@@ -100,6 +163,39 @@ class BrickletGas(Device):
         self.response_expected[BrickletGas.FUNCTION_GET_CALIBRATION] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
         self.response_expected[BrickletGas.FUNCTION_SET_VALUES_CALLBACK_CONFIGURATION] = BrickletGas.RESPONSE_EXPECTED_TRUE
         self.response_expected[BrickletGas.FUNCTION_GET_VALUES_CALLBACK_CONFIGURATION] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
+        self.response_expected[BrickletGas.FUNCTION_GET_EXPOSURE] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
+        self.response_expected[BrickletGas.FUNCTION_SET_EXPOSURE_LIMIT_CONFIGURATION] = BrickletGas.RESPONSE_EXPECTED_TRUE
+        self.response_expected[BrickletGas.FUNCTION_GET_EXPOSURE_LIMIT_CONFIGURATION] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
+        self.response_expected[BrickletGas.FUNCTION_GET_CONCENTRATION_SLOPE] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
+        self.response_expected[BrickletGas.FUNCTION_SET_CONCENTRATION_SLOPE_CONFIGURATION] = BrickletGas.RESPONSE_EXPECTED_FALSE
+        self.response_expected[BrickletGas.FUNCTION_GET_CONCENTRATION_SLOPE_CONFIGURATION] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
+        self.response_expected[BrickletGas.FUNCTION_SET_CONCENTRATION_SLOPE_CALLBACK_CONFIGURATION] = BrickletGas.RESPONSE_EXPECTED_TRUE
+        self.response_expected[BrickletGas.FUNCTION_GET_CONCENTRATION_SLOPE_CALLBACK_CONFIGURATION] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
+        self.response_expected[BrickletGas.FUNCTION_SAVE_CONFIGURATION] = BrickletGas.RESPONSE_EXPECTED_FALSE
+        self.response_expected[BrickletGas.FUNCTION_RESTORE_CONFIGURATION] = BrickletGas.RESPONSE_EXPECTED_FALSE
+        self.response_expected[BrickletGas.FUNCTION_GET_I2C_ERROR_COUNT] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
+        self.response_expected[BrickletGas.FUNCTION_GET_MAIN_LOOP_STATISTICS] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
+        self.response_expected[BrickletGas.FUNCTION_READ_TRACE] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
+        self.response_expected[BrickletGas.FUNCTION_SET_SENSOR_TABLE] = BrickletGas.RESPONSE_EXPECTED_FALSE
+        self.response_expected[BrickletGas.FUNCTION_GET_SENSOR_TABLE] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
+        self.response_expected[BrickletGas.FUNCTION_RESET_SENSOR_TABLE] = BrickletGas.RESPONSE_EXPECTED_FALSE
+        self.response_expected[BrickletGas.FUNCTION_GET_VALUES_EXTENDED] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
+        self.response_expected[BrickletGas.FUNCTION_SET_OUTLIER_FILTER_CONFIGURATION] = BrickletGas.RESPONSE_EXPECTED_FALSE
+        self.response_expected[BrickletGas.FUNCTION_GET_OUTLIER_FILTER_CONFIGURATION] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
+        self.response_expected[BrickletGas.FUNCTION_GET_OUTLIER_FILTER_COUNT] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
+        self.response_expected[BrickletGas.FUNCTION_SET_BASELINE_TRACKING_CONFIGURATION] = BrickletGas.RESPONSE_EXPECTED_FALSE
+        self.response_expected[BrickletGas.FUNCTION_GET_BASELINE_TRACKING_CONFIGURATION] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
+        self.response_expected[BrickletGas.FUNCTION_GET_BASELINE_OFFSET] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
+        self.response_expected[BrickletGas.FUNCTION_SET_LOW_POWER_CONFIGURATION] = BrickletGas.RESPONSE_EXPECTED_FALSE
+        self.response_expected[BrickletGas.FUNCTION_GET_LOW_POWER_CONFIGURATION] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
+        self.response_expected[BrickletGas.FUNCTION_START_CALIBRATION_CAPTURE] = BrickletGas.RESPONSE_EXPECTED_FALSE
+        self.response_expected[BrickletGas.FUNCTION_GET_CALIBRATION_CAPTURE] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
+        self.response_expected[BrickletGas.FUNCTION_SET_DIAGNOSTIC_CONFIGURATION] = BrickletGas.RESPONSE_EXPECTED_FALSE
+        self.response_expected[BrickletGas.FUNCTION_GET_DIAGNOSTIC_CONFIGURATION] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
+        self.response_expected[BrickletGas.FUNCTION_GET_DIAGNOSTIC_STATUS] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
+        self.response_expected[BrickletGas.FUNCTION_SET_WATCHDOG_CONFIGURATION] = BrickletGas.RESPONSE_EXPECTED_FALSE
+        self.response_expected[BrickletGas.FUNCTION_GET_WATCHDOG_CONFIGURATION] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
+        self.response_expected[BrickletGas.FUNCTION_GET_DATA_AGE] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
         self.response_expected[BrickletGas.FUNCTION_GET_SPITFP_ERROR_COUNT] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
         self.response_expected[BrickletGas.FUNCTION_SET_BOOTLOADER_MODE] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
         self.response_expected[BrickletGas.FUNCTION_GET_BOOTLOADER_MODE] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
@@ -114,6 +210,8 @@ class BrickletGas(Device):
         self.response_expected[BrickletGas.FUNCTION_GET_IDENTITY] = BrickletGas.RESPONSE_EXPECTED_ALWAYS_TRUE
 
         self.callback_formats[BrickletGas.CALLBACK_VALUES] = 'i h H B'
+        self.callback_formats[BrickletGas.CALLBACK_EXPOSURE_LIMIT] = 'i i ! !'
+        self.callback_formats[BrickletGas.CALLBACK_CONCENTRATION_SLOPE] = 'i'
 
 
     def get_values(self):
@@ -122,12 +220,27 @@ class BrickletGas(Device):
         """
         return GetValues(*self.ipcon.send_request(self, BrickletGas.FUNCTION_GET_VALUES, (), '', 'i h H B'))
 
+    def get_values_async(self, timeout=None):
+        """
+        Same as :func:`Get Values`, but returns a Future instead of waiting for
+        the response. Call result() on it to get the values. Many requests to
+        one or more Bricklets can be in flight at the same time.
+        """
+        return self.ipcon.send_request_async(self, BrickletGas.FUNCTION_GET_VALUES, (), '', 'i h H B', timeout, lambda r: GetValues(*r))
+
     def get_adc_count(self):
         """
 
         """
         return self.ipcon.send_request(self, BrickletGas.FUNCTION_GET_ADC_COUNT, (), '', 'I')
 
+    def get_adc_count_async(self, timeout=None):
+        """
+        Same as :func:`Get ADC Count`, but returns a Future instead of waiting
+        for the response.
+        """
+        return self.ipcon.send_request_async(self, BrickletGas.FUNCTION_GET_ADC_COUNT, (), '', 'I', timeout)
+
     def set_calibration(self, adc_count_zero, temperature_zero, humidity_zero, compensation_zero_low, compensation_zero_high, ppm_span, adc_count_span, temperature_span, humidity_span, compensation_span_low, compensation_span_high, temperature_offset, humidity_offset, sensitivity):
         """
 
@@ -181,6 +294,476 @@ class BrickletGas(Device):
         """
         return GetValuesCallbackConfiguration(*self.ipcon.send_request(self, BrickletGas.FUNCTION_GET_VALUES_CALLBACK_CONFIGURATION, (), '', 'I !'))
 
+    def get_exposure(self):
+        """
+        Returns the 8 hour time weighted average (TWA) and the 15 minute
+        short-term exposure (STEL) of the gas concentration in ppb.
+
+        The exposure is accumulated on the Bricklet from every measurement,
+        independent of how often this function is called. The TWA is always
+        divided by the full 8 hours (480 minutes), as for the 8 hour exposure
+        limits. Time before the start of the Bricklet counts as zero exposure,
+        so within the first 8 hours the TWA is lower than the average
+        concentration so far. The number of already accumulated minutes
+        (saturates at 480) is returned as *minutes*, the average over the
+        accumulated time is *twa* * 480 / *minutes*.
+        """
+        return GetExposure(*self.ipcon.send_request(self, BrickletGas.FUNCTION_GET_EXPOSURE, (), '', 'i i H'))
+
+    def set_exposure_limit_configuration(self, twa_limit, stel_limit):
+        """
+        Sets the TWA and STEL exposure limits in ppb. If one of the
+        limits is exceeded, the :cb:`Exposure Limit` callback is triggered.
+        It is triggered again as soon as the exposure is below all limits.
+
+        A limit of 0 turns the corresponding check off.
+
+        The default value is (0, 0).
+        """
+        twa_limit = int(twa_limit)
+        stel_limit = int(stel_limit)
+
+        self.ipcon.send_request(self, BrickletGas.FUNCTION_SET_EXPOSURE_LIMIT_CONFIGURATION, (twa_limit, stel_limit), 'I I', '')
+
+    def get_exposure_limit_configuration(self):
+        """
+        Returns the exposure limits as set by
+        :func:`Set Exposure Limit Configuration`.
+        """
+        return GetExposureLimitConfiguration(*self.ipcon.send_request(self, BrickletGas.FUNCTION_GET_EXPOSURE_LIMIT_CONFIGURATION, (), '', 'I I'))
+
+    def get_concentration_slope(self):
+        """
+        Returns the rate of change of the gas concentration in ppb per minute.
+
+        The slope is a least-squares fit over the last ADC samples, see
+        :func:`Set Concentration Slope Configuration`.
+        """
+        return self.ipcon.send_request(self, BrickletGas.FUNCTION_GET_CONCENTRATION_SLOPE, (), '', 'i')
+
+    def set_concentration_slope_configuration(self, window_size):
+        """
+        Sets the number of ADC samples (2 to 32) that are used for the
+        least-squares fit of the concentration slope. The ADC is sampled
+        with 4 SPS. A larger window reduces noise but increases the delay
+        until a fast rise is detected.
+
+        The default value is 8.
+        """
+        window_size = int(window_size)
+
+        self.ipcon.send_request(self, BrickletGas.FUNCTION_SET_CONCENTRATION_SLOPE_CONFIGURATION, (window_size,), 'B', '')
+
+    def get_concentration_slope_configuration(self):
+        """
+        Returns the configuration as set by :func:`Set Concentration Slope Configuration`.
+        """
+        return self.ipcon.send_request(self, BrickletGas.FUNCTION_GET_CONCENTRATION_SLOPE_CONFIGURATION, (), '', 'B')
+
+    def set_concentration_slope_callback_configuration(self, period, value_has_to_change, option, min, max):
+        """
+        The period in ms is the period with which the :cb:`Concentration Slope` callback is triggered
+        periodically. A value of 0 turns the callback off.
+
+        If the `value has to change`-parameter is set to true, the callback is only
+        triggered after the value has changed. If the value didn't change
+        within the period, the callback is triggered immediately on change.
+
+        If it is set to false, the callback is continuously triggered with the period,
+        independent of the value.
+
+        It is furthermore possible to constrain the callback with thresholds.
+
+        The `option`-parameter together with min/max sets a threshold for the :cb:`Concentration Slope` callback.
+
+        The following options are possible:
+
+        .. csv-table::
+         :header: "Option", "Description"
+         :widths: 10, 100
+
+         "'x'",    "Threshold is turned off"
+         "'o'",    "Threshold is triggered when the value is *outside* the min and max values"
+         "'i'",    "Threshold is triggered when the value is *inside* or equal to the min and max values"
+         "'<'",    "Threshold is triggered when the value is smaller than the min value (max is ignored)"
+         "'>'",    "Threshold is triggered when the value is greater than the min value (max is ignored)"
+
+        If the option is set to 'x' (threshold turned off) the callback is triggered with the fixed period.
+
+        The default value is (0, false, 'x', 0, 0).
+        """
+        period = int(period)
+        value_has_to_change = bool(value_has_to_change)
+        option = create_char(option)
+        min = int(min)
+        max = int(max)
+
+        self.ipcon.send_request(self, BrickletGas.FUNCTION_SET_CONCENTRATION_SLOPE_CALLBACK_CONFIGURATION, (period, value_has_to_change, option, min, max), 'I ! c i i', '')
+
+    def get_concentration_slope_callback_configuration(self):
+        """
+        Returns the callback configuration as set by :func:`Set Concentration Slope Callback Configuration`.
+        """
+        return GetConcentrationSlopeCallbackConfiguration(*self.ipcon.send_request(self, BrickletGas.FUNCTION_GET_CONCENTRATION_SLOPE_CALLBACK_CONFIGURATION, (), '', 'I ! c i i'))
+
+    def save_configuration(self):
+        """
+        Saves the current runtime configuration to flash. After a power cycle
+        the Bricklet starts with the saved configuration, so callbacks are
+        triggered immediately without reconfiguration by the host.
+
+        The runtime configuration contains:
+
+        * :func:`Set Values Callback Configuration`,
+        * :func:`Set Exposure Limit Configuration`,
+        * :func:`Set Concentration Slope Configuration` and
+        * :func:`Set Concentration Slope Callback Configuration`.
+        """
+        self.ipcon.send_request(self, BrickletGas.FUNCTION_SAVE_CONFIGURATION, (), '', '')
+
+    def restore_configuration(self):
+        """
+        Discards all runtime configuration changes since the last
+        :func:`Save Configuration` and restores the saved configuration.
+        """
+        self.ipcon.send_request(self, BrickletGas.FUNCTION_RESTORE_CONFIGURATION, (), '', '')
+
+    def get_i2c_error_count(self):
+        """
+        Returns the error counts for the I2C bus between the microcontroller
+        and the sensor chips (LMP91000, MCP3423 and HDC1080).
+
+        * Transfer errors: Failed I2C transfers. A failed transfer is retried
+          up to two times.
+        * Bus recoveries: The bus was freed by clocking SCL before a retry.
+        * Reinitializations: A sensor chip was reconfigured after a transfer
+          still failed after all retries.
+        """
+        return GetI2CErrorCount(*self.ipcon.send_request(self, BrickletGas.FUNCTION_GET_I2C_ERROR_COUNT, (), '', 'I I I'))
+
+    def get_main_loop_statistics(self):
+        """
+        Returns statistics of the firmware main loop, counted over the
+        last second:
+
+        * Loops per second: Number of main loop passes.
+        * Task resumes per second: Number of passes in which the measurement
+          task was resumed. All other passes are idle time for the measurement
+          task that is available for the communication with the Brick.
+        * I2C interrupts per second: Number of I2C interrupts that woke the
+          measurement task during an I2C transfer.
+        """
+        return GetMainLoopStatistics(*self.ipcon.send_request(self, BrickletGas.FUNCTION_GET_MAIN_LOOP_STATISTICS, (), '', 'I I I'))
+
+    def read_trace(self):
+        """
+        Reads up to 4 events from the binary trace buffer of the firmware.
+        Each event is 12 bytes: time (lower 16 bit in ms, uint16), event id
+        (uint8), reserved (uint8), argument 0 (int32) and argument 1 (int32).
+
+        Events lost is the number of events that were overwritten since the
+        last call, because the trace buffer (32 events) was full.
+
+        Call this function until events length is 0 to drain the buffer.
+        tests/trace.py decodes the events.
+        """
+        return ReadTrace(*self.ipcon.send_request(self, BrickletGas.FUNCTION_READ_TRACE, (), '', 'H B 48B'))
+
+    def set_sensor_table(self, gas_type, tiacn, refcn, modecn, compensation_zero_low, compensation_zero_high, compensation_span_low, compensation_span_high):
+        """
+        Uploads the sensor table of the given gas type. The table consists
+        of the LMP91000 TIACN, REFCN and MODECN register values and the
+        temperature compensation of the sensor:
+
+        * Compensation zero low/high: Zero drift below/above 25 °C in pA/°C.
+        * Compensation span low/high: Span drift below/above 25 °C in %/°C/1000.
+
+        The table is stored in the EEPROM and replaces the firmware default
+        of the gas type until :func:`Reset Sensor Table` is called. If the
+        gas type is the configured gas type, the LMP91000 is reconfigured
+        immediately.
+
+        Register values with reserved bits, a bias above 24% or an unsupported
+        operating mode are rejected. The temperature measurement modes are
+        not supported, the ADC only measures VOUT of the LMP91000 and the
+        temperature sensor would replace the gas signal.
+        """
+        gas_type = int(gas_type)
+        tiacn = int(tiacn)
+        refcn = int(refcn)
+        modecn = int(modecn)
+        compensation_zero_low = int(compensation_zero_low)
+        compensation_zero_high = int(compensation_zero_high)
+        compensation_span_low = int(compensation_span_low)
+        compensation_span_high = int(compensation_span_high)
+
+        self.ipcon.send_request(self, BrickletGas.FUNCTION_SET_SENSOR_TABLE, (gas_type, tiacn, refcn, modecn, compensation_zero_low, compensation_zero_high, compensation_span_low, compensation_span_high), 'B B B B i i i i', '')
+
+    def get_sensor_table(self, gas_type):
+        """
+        Returns the sensor table of the given gas type as set by :func:`Set Sensor Table`.
+
+        Custom is *true* if the table was uploaded and *false* if the
+        firmware default is used.
+        """
+        gas_type = int(gas_type)
+
+        return GetSensorTable(*self.ipcon.send_request(self, BrickletGas.FUNCTION_GET_SENSOR_TABLE, (gas_type,), 'B', 'B B B i i i i !'))
+
+    def reset_sensor_table(self, gas_type):
+        """
+        Restores the firmware default sensor table of the given gas type.
+        """
+        gas_type = int(gas_type)
+
+        self.ipcon.send_request(self, BrickletGas.FUNCTION_RESET_SENSOR_TABLE, (gas_type,), 'B', '')
+
+    def get_values_extended(self):
+        """
+        Returns the same values as :func:`Get Values` and additionally the
+        resolution of the gas concentration in ppb and the age of the gas
+        concentration and of temperature and humidity in ms.
+
+        The gas concentration is rounded to a multiple of the resolution. The
+        resolution depends on the gas type: It is the noise floor of the
+        sensor or one ADC count (given by sensitivity and TIA gain),
+        whichever is larger, rounded up to a 1-2-5 step.
+
+        The ages are measured from the conversion the values were calculated
+        from, they are the same as the ages of :func:`Get Data Age` for these
+        values. An age well above the time between two measurements (250 ms
+        and 1000 ms, or the low power interval) marks stale values.
+        """
+        return GetValuesExtended(*self.ipcon.send_request(self, BrickletGas.FUNCTION_GET_VALUES_EXTENDED, (), '', 'i h H B I I I'))
+
+    def set_outlier_filter_configuration(self, mode, window_size, threshold):
+        """
+        Configures the filter that removes single sample spikes (ESD, bus
+        glitches) from the ADC count before the concentration is calculated.
+
+        * Off: The ADC count is used as is.
+        * Median: The running median of the last window size samples is used.
+        * MAD: An ADC count that is more than threshold standard deviations
+          (estimated from the median absolute deviation) away from the median
+          is replaced by the median, all other samples are used as is.
+
+        The window size has to be odd (3 to 9), the threshold is given in
+        standard deviations/100 (at least 100). A lasting change of the
+        concentration passes the filter after half the window size.
+
+        The default is off, window size 5 and threshold 500 (5 standard deviations).
+        The configuration is saved with :func:`Save Configuration`.
+        """
+        mode = int(mode)
+        window_size = int(window_size)
+        threshold = int(threshold)
+
+        self.ipcon.send_request(self, BrickletGas.FUNCTION_SET_OUTLIER_FILTER_CONFIGURATION, (mode, window_size, threshold), 'B B H', '')
+
+    def get_outlier_filter_configuration(self):
+        """
+        Returns the outlier filter configuration as set by :func:`Set Outlier Filter Configuration`.
+        """
+        return GetOutlierFilterConfiguration(*self.ipcon.send_request(self, BrickletGas.FUNCTION_GET_OUTLIER_FILTER_CONFIGURATION, (), '', 'B B H'))
+
+    def get_outlier_filter_count(self):
+        """
+        Returns the number of ADC counts that were detected as outliers since
+        startup. In median mode the outliers are counted as well.
+        """
+        return self.ipcon.send_request(self, BrickletGas.FUNCTION_GET_OUTLIER_FILTER_COUNT, (), '', 'I')
+
+    def set_baseline_tracking_configuration(self, enable, time_constant, quiet_threshold, limit):
+        """
+        Configures the automatic tracking of the zero drift of the sensor.
+
+        The ADC count is collected in blocks of one minute. A block is quiet if
+        the concentration changed by less than the quiet threshold (in ppb)
+        within the block. The mean of quiet blocks moves the zero: Downwards
+        within a few minutes, upwards only with the time constant (in minutes,
+        at least 10). The learned offset is limited to +-limit (in ppb).
+
+        Disabling the tracking discards the learned offset, a new
+        :func:`Set Calibration` restarts it. The learned offset is stored
+        together with the configuration by :func:`Save Configuration`. A
+        stored offset is not used anymore once the zero is calibrated again.
+
+        The default is disabled, a time constant of 1440 minutes (one day),
+        a quiet threshold of 100 ppb and a limit of 5000 ppb.
+        """
+        enable = bool(enable)
+        time_constant = int(time_constant)
+        quiet_threshold = int(quiet_threshold)
+        limit = int(limit)
+
+        self.ipcon.send_request(self, BrickletGas.FUNCTION_SET_BASELINE_TRACKING_CONFIGURATION, (enable, time_constant, quiet_threshold, limit), '! H I I', '')
+
+    def get_baseline_tracking_configuration(self):
+        """
+        Returns the baseline tracking configuration as set by :func:`Set Baseline Tracking Configuration`.
+        """
+        return GetBaselineTrackingConfiguration(*self.ipcon.send_request(self, BrickletGas.FUNCTION_GET_BASELINE_TRACKING_CONFIGURATION, (), '', '! H I I'))
+
+    def get_baseline_offset(self):
+        """
+        Returns the learned zero offset in ADC counts and in ppb (the
+        concentration that is subtracted at the current temperature) and the
+        number of quiet minutes it was learned from.
+        """
+        return GetBaselineOffset(*self.ipcon.send_request(self, BrickletGas.FUNCTION_GET_BASELINE_OFFSET, (), '', 'i i I'))
+
+    def set_low_power_configuration(self, enable, interval):
+        """
+        Enables the low power mode. The gas concentration, temperature and
+        humidity are then measured only once per interval (in ms, 1000 to
+        3600000) instead of 4 times per second. The ADC runs a single
+        conversion per interval and is in standby in between, the
+        microcontroller sleeps while nothing is to do. The LMP91000 stays
+        active, the sensor would need minutes to hours to stabilize again.
+
+        Estimated average current of the sensor front end (without the
+        microcontroller) from the typical datasheet values and latency of a
+        concentration step until it is measured:
+
+        * Continuous: 158 uA, 0.3 s to 0.7 s.
+        * Interval 1 s: 52 uA, up to 1.3 s.
+        * Interval 10 s: 15 uA, up to 10.3 s.
+        * Interval 60 s: 11 uA, up to 60.3 s.
+
+        The period of the values callback adds to the latency. The slope and
+        the baseline tracking use the interval as time between two samples.
+
+        The default is disabled. The configuration is saved with :func:`Save Configuration`.
+        """
+        enable = bool(enable)
+        interval = int(interval)
+
+        self.ipcon.send_request(self, BrickletGas.FUNCTION_SET_LOW_POWER_CONFIGURATION, (enable, interval), '! I', '')
+
+    def get_low_power_configuration(self):
+        """
+        Returns the low power configuration as set by :func:`Set Low Power Configuration`.
+        """
+        return GetLowPowerConfiguration(*self.ipcon.send_request(self, BrickletGas.FUNCTION_GET_LOW_POWER_CONFIGURATION, (), '', '! I'))
+
+    def start_calibration_capture(self, sample_count):
+        """
+        Starts to average the next *sample_count* ADC counts (2 to 14400,
+        4 samples per second) for a calibration point, e.g. with zero gas or
+        span gas applied. The samples are taken after the outlier filter and
+        without the baseline offset, temperature and humidity are averaged
+        as well. A running capture is discarded.
+
+        The result is read with :func:`Get Calibration Capture`, the values
+        can then be written with :func:`Set Calibration`.
+        """
+        sample_count = int(sample_count)
+
+        self.ipcon.send_request(self, BrickletGas.FUNCTION_START_CALIBRATION_CAPTURE, (sample_count,), 'H', '')
+
+    def get_calibration_capture(self):
+        """
+        Returns the state of the calibration capture (idle, running or
+        done), the number of samples averaged so far, their mean and
+        standard deviation in 1/100 ADC counts, the mean as sensor current
+        in pA at the current TIA gain and the mean temperature (°C/100) and
+        humidity (%RH/100).
+
+        The current is the absolute mean ADC count times the nA per count of
+        the TIA gain. It includes the zero offset of the sensor and the ADC,
+        so only the difference between two captures (e.g. span gas and zero
+        gas) is meaningful.
+
+        The values are updated with every sample while the capture is
+        running and are kept once it is done.
+        """
+        return GetCalibrationCapture(*self.ipcon.send_request(self, BrickletGas.FUNCTION_GET_CALIBRATION_CAPTURE, (), '', 'B H i I i h H'))
+
+    def set_diagnostic_configuration(self, interval, response_min):
+        """
+        Configures the sensor health diagnostic. Once per *interval* (in s,
+        300 to 604800, 0 turns the diagnostic off) the Bricklet checks that
+        the LMP91000 still holds its configuration and moves the sensor bias
+        by one step for two samples. A working cell answers with a charging
+        current, the largest change of the ADC count during the step has to
+        be at least *response_min* ADC counts. Otherwise the cell is
+        reported as not responding (disconnected or dried out).
+
+        The samples during the step and until the cell has recovered are
+        replaced by the last sample before the step, at most 10 samples
+        (2.5 s) per run. In low power mode only the configuration is
+        checked. A run is postponed while a calibration capture is running.
+
+        The result is read with :func:`Get Diagnostic Status`.
+
+        The default is an interval of 3600 s and a minimum response of 50
+        ADC counts, the first run is one minute after the start. The
+        configuration is saved with :func:`Save Configuration`.
+        """
+        interval = int(interval)
+        response_min = int(response_min)
+
+        self.ipcon.send_request(self, BrickletGas.FUNCTION_SET_DIAGNOSTIC_CONFIGURATION, (interval, response_min), 'I I', '')
+
+    def get_diagnostic_configuration(self):
+        """
+        Returns the diagnostic configuration as set by :func:`Set Diagnostic Configuration`.
+        """
+        return GetDiagnosticConfiguration(*self.ipcon.send_request(self, BrickletGas.FUNCTION_GET_DIAGNOSTIC_CONFIGURATION, (), '', 'I I'))
+
+    def get_diagnostic_status(self):
+        """
+        Returns the result of the last diagnostic run, the bias step response
+        in ADC counts and the number of runs and of runs that found the
+        LMP91000 configuration changed (it is written again in that case).
+
+        The status is one of:
+
+        * Not run: No run since the start.
+        * OK: The configuration is unchanged and the cell responded to the bias step.
+        * Register error: The LMP91000 configuration was changed or could not be read.
+        * No response: The cell did not respond to the bias step.
+        * Saturated: The sensor signal is at the end of the ADC range, e.g. a shorted cell.
+        * Not recovered: The cell responded but did not return to the signal before the
+          bias step within 2s, e.g. an aging cell.
+        """
+        return GetDiagnosticStatus(*self.ipcon.send_request(self, BrickletGas.FUNCTION_GET_DIAGNOSTIC_STATUS, (), '', 'B I I I'))
+
+    def set_watchdog_configuration(self, timeout):
+        """
+        Sets the timeout of the measurement watchdog in ms (5000 to 3600000,
+        0 turns the watchdog off). If the ADC count or the temperature and
+        humidity were not updated for longer than the timeout on top of the
+        time between two measurements (e.g. because an I2C transfer hangs),
+        the Bricklet resets the I2C bus and starts the measurement again,
+        which configures the sensor chips again. Calibration and
+        configuration are kept, the Bricklet is not reset.
+
+        If a restart does not bring the measurements back, the timeout is
+        doubled for the next restart (up to 64 times).
+
+        The default is 10000 ms. The configuration is saved with :func:`Save Configuration`.
+        """
+        timeout = int(timeout)
+
+        self.ipcon.send_request(self, BrickletGas.FUNCTION_SET_WATCHDOG_CONFIGURATION, (timeout,), 'I', '')
+
+    def get_watchdog_configuration(self):
+        """
+        Returns the watchdog timeout as set by :func:`Set Watchdog Configuration`.
+        """
+        return self.ipcon.send_request(self, BrickletGas.FUNCTION_GET_WATCHDOG_CONFIGURATION, (), '', 'I')
+
+    def get_data_age(self):
+        """
+        Returns the time in ms since the ADC count and since the temperature
+        and humidity were last updated, and how often the watchdog restarted
+        the measurement. The values returned by :func:`Get Values` are as
+        old as these ages. Normally the ages stay below the time between two
+        measurements (250 ms and 1000 ms, or the low power interval).
+        """
+        return GetDataAge(*self.ipcon.send_request(self, BrickletGas.FUNCTION_GET_DATA_AGE, (), '', 'I I I'))
+
     def get_spitfp_error_count(self):
         """
         Returns the error count for the communication between Brick and Bricklet.
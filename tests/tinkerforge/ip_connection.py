@@ -22,20 +22,22 @@ try:
 except ImportError:
     import Queue as queue # Python 2
 
-def get_uid_from_data(data):
-    return struct.unpack('<I', data[0:4])[0]
+HEADER_STRUCT = struct.Struct('<IBBBB')
 
-def get_length_from_data(data):
-    return struct.unpack('<B', data[4:5])[0]
+def get_uid_from_data(data, offset=0):
+    return struct.unpack_from('<I', data, offset)[0]
 
-def get_function_id_from_data(data):
-    return struct.unpack('<B', data[5:6])[0]
+def get_length_from_data(data, offset=0):
+    return struct.unpack_from('<B', data, offset + 4)[0]
 
-def get_sequence_number_from_data(data):
-    return (struct.unpack('<B', data[6:7])[0] >> 4) & 0x0F
+def get_function_id_from_data(data, offset=0):
+    return struct.unpack_from('<B', data, offset + 5)[0]
 
-def get_error_code_from_data(data):
-    return (struct.unpack('<B', data[7:8])[0] >> 6) & 0x03
+def get_sequence_number_from_data(data, offset=0):
+    return (struct.unpack_from('<B', data, offset + 6)[0] >> 4) & 0x0F
+
+def get_error_code_from_data(data, offset=0):
+    return (struct.unpack_from('<B', data, offset + 7)[0] >> 6) & 0x03
 
 BASE58 = '123456789abcdefghijkmnopqrstuvwxyzABCDEFGHJKLMNPQRSTUVWXYZ'
 
@@ -194,111 +196,177 @@ else:
         else:
             return ''.join(create_char_list(value, expected_type='string'))
 
-def pack_payload(data, form):
-    if sys.hexversion < 0x03000000:
-        packed = ''
-    else:
-        packed = b''
+class PayloadCodec(object):
+    """
+    Precompiled codec for one payload format string. The whole payload is
+    packed and unpacked with a single struct.Struct, the fields are only
+    converted afterwards.
+    """
 
-    for f, d in zip(form.split(' '), data):
-        if '!' in f:
-            if len(f) > 1:
-                if int(f.replace('!', '')) != len(d):
-                    raise ValueError('Incorrect bool list length')
+    FIELD_NUMBER = 0
+    FIELD_BOOL = 1
+    FIELD_BOOL_ARRAY = 2
+    FIELD_CHAR = 3
+    FIELD_STRING = 4
 
-                p = [0] * int(math.ceil(len(d) / 8.0))
+    def __init__(self, form):
+        struct_form = '<'
+        fields = [] # [kind, count, is_array, bits]
 
-                for i, b in enumerate(d):
-                    if b:
-                        p[i // 8] |= 1 << (i % 8)
+        for f in form.split(' '):
+            if len(f) == 0:
+                continue
 
-                packed += struct.pack('<{0}B'.format(len(p)), *p)
-            else:
-                packed += struct.pack('<?', d)
-        elif 'c' in f:
-            if sys.hexversion < 0x03000000:
-                if len(f) > 1:
-                    packed += struct.pack('<' + f, *d)
-                else:
-                    packed += struct.pack('<' + f, d)
-            else:
+            if '!' in f:
                 if len(f) > 1:
-                    packed += struct.pack('<' + f, *list(map(lambda char: bytes([ord(char)]), d)))
+                    bits = int(f.replace('!', ''))
+                    count = int(math.ceil(bits / 8.0))
+                    struct_form += '{0}B'.format(count)
+                    fields.append((PayloadCodec.FIELD_BOOL_ARRAY, count, True, bits))
                 else:
-                    packed += struct.pack('<' + f, bytes([ord(d)]))
-        elif 's' in f:
-            if sys.hexversion < 0x03000000:
-                packed += struct.pack('<' + f, d)
+                    struct_form += 'B'
+                    fields.append((PayloadCodec.FIELD_BOOL, 1, False, 1))
+            elif 's' in f:
+                struct_form += f
+                fields.append((PayloadCodec.FIELD_STRING, 1, False, 0))
             else:
-                packed += struct.pack('<' + f, bytes(map(ord, d)))
-        elif len(f) > 1:
-            packed += struct.pack('<' + f, *d)
-        else:
-            packed += struct.pack('<' + f, d)
+                count = struct.calcsize('<' + f) // struct.calcsize('<' + f[-1])
+                struct_form += f
 
-    return packed
+                if 'c' in f:
+                    fields.append((PayloadCodec.FIELD_CHAR, count, len(f) > 1, 0))
+                else:
+                    fields.append((PayloadCodec.FIELD_NUMBER, count, len(f) > 1, 0))
+
+        self.form = form
+        self.struct = struct.Struct(struct_form)
+        self.size = self.struct.size
+        self.fields = fields
+        # Payloads of scalar numbers only can be passed to and from the
+        # struct directly, this covers most getters, setters and callbacks
+        self.plain = all(kind == PayloadCodec.FIELD_NUMBER and not is_array
+                         for kind, count, is_array, bits in fields)
+
+    def pack(self, data):
+        if self.plain:
+            return self.struct.pack(*data)
+
+        values = []
+
+        for (kind, count, is_array, bits), d in zip(self.fields, data):
+            if kind == PayloadCodec.FIELD_BOOL:
+                values.append(1 if d else 0)
+            elif kind == PayloadCodec.FIELD_BOOL_ARRAY:
+                if bits != len(d):
+                    raise ValueError('Incorrect bool list length')
 
-def unpack_payload(data, form):
-    ret = []
+                p = [0] * count
 
-    for f in form.split(' '):
-        o = f
+                for i, b in enumerate(d):
+                    if b:
+                        p[i // 8] |= 1 << (i % 8)
 
-        if '!' in f:
-            if len(f) > 1:
-                f = '{0}B'.format(int(math.ceil(int(f.replace('!', '')) / 8.0)))
+                values.extend(p)
+            elif kind == PayloadCodec.FIELD_STRING:
+                if sys.hexversion < 0x03000000:
+                    values.append(d)
+                else:
+                    values.append(bytes(map(ord, d)))
             else:
-                f = 'B'
+                if not is_array:
+                    d = (d,)
+                elif len(d) != count:
+                    raise struct.error('pack expected {0} items for packing (got {1})'.format(count, len(d)))
 
-        f = '<' + f
-        length = struct.calcsize(f)
-        x = struct.unpack(f, data[:length])
+                if kind == PayloadCodec.FIELD_CHAR and sys.hexversion >= 0x03000000:
+                    d = [bytes([ord(char)]) for char in d]
 
-        if '!' in o:
-            y = []
+                values.extend(d)
 
-            if len(o) > 1:
-                for i in range(int(o.replace('!', ''))):
-                    y.append(x[i // 8] & (1 << (i % 8)) != 0)
-            else:
-                y.append(x[0] != 0)
+        return self.struct.pack(*values)
 
-            x = tuple(y)
+    def unpack(self, data, offset=0):
+        values = self.struct.unpack_from(data, offset)
 
-        if 'c' in f:
-            if sys.hexversion < 0x03000000:
-                if len(x) > 1:
-                    ret.append(x)
-                else:
-                    ret.append(x[0])
+        if self.plain:
+            if len(values) == 1:
+                return values[0]
             else:
-                if len(x) > 1:
-                    ret.append(tuple(map(lambda item: chr(ord(item)), x)))
+                return list(values)
+
+        ret = []
+        i = 0
+
+        for kind, count, is_array, bits in self.fields:
+            x = values[i:i + count]
+            i += count
+
+            if kind == PayloadCodec.FIELD_BOOL:
+                x = (x[0] != 0,)
+            elif kind == PayloadCodec.FIELD_BOOL_ARRAY:
+                x = tuple([x[k // 8] & (1 << (k % 8)) != 0 for k in range(bits)])
+            elif kind == PayloadCodec.FIELD_CHAR and sys.hexversion >= 0x03000000:
+                x = tuple([chr(ord(item)) for item in x])
+            elif kind == PayloadCodec.FIELD_STRING:
+                if sys.hexversion < 0x03000000:
+                    s = x[0]
                 else:
-                    ret.append(chr(ord(x[0])))
-        elif 's' in f:
-            if sys.hexversion < 0x03000000:
-                s = x[0]
-            else:
-                s = ''.join(map(chr, x[0]))
+                    s = ''.join(map(chr, x[0]))
+
+                k = s.find('\x00')
+
+                if k >= 0:
+                    s = s[:k]
 
-            i = s.find('\x00')
+                ret.append(s)
+                continue
 
-            if i >= 0:
-                s = s[:i]
+            if len(x) > 1:
+                ret.append(x)
+            else:
+                ret.append(x[0])
 
-            ret.append(s)
-        elif len(x) > 1:
-            ret.append(x)
+        if len(ret) == 1:
+            return ret[0]
         else:
-            ret.append(x[0])
+            return ret
+
+payload_codecs = {} # form -> PayloadCodec
 
-        data = data[length:]
+def get_payload_codec(form):
+    # Every function and callback ID has a fixed format string, so the
+    # cache is bounded by the number of distinct formats in the bindings
+    try:
+        return payload_codecs[form]
+    except KeyError:
+        codec = PayloadCodec(form)
+        payload_codecs[form] = codec
+        return codec
 
-    if len(ret) == 1:
-        return ret[0]
+def pack_payload(data, form):
+    return get_payload_codec(form).pack(data)
+
+def unpack_payload(data, form, offset=0):
+    return get_payload_codec(form).unpack(data, offset)
+
+def unpack_response(function_id, response, form_ret):
+    error_code = get_error_code_from_data(response)
+
+    if error_code == 0:
+        # no error
+        pass
+    elif error_code == 1:
+        msg = 'Got invalid parameter for function {0}'.format(function_id)
+        raise Error(Error.INVALID_PARAMETER, msg)
+    elif error_code == 2:
+        msg = 'Function {0} is not supported'.format(function_id)
+        raise Error(Error.NOT_SUPPORTED, msg)
     else:
-        return ret
+        msg = 'Function {0} returned an unknown error'.format(function_id)
+        raise Error(Error.UNKNOWN_ERROR_CODE, msg)
+
+    if len(form_ret) > 0:
+        return unpack_payload(response, form_ret, 8)
 
 class Error(Exception):
     TIMEOUT = -1
@@ -329,6 +397,72 @@ class Error(Exception):
             self.__cause__ = None
             self.__suppress_context__ = True
 
+class Future(object):
+    """
+    Result of a request sent with :func:`IPConnection.send_request_async`.
+    The response is matched by UID, function ID and sequence number, so
+    many requests can be in flight on one connection at the same time.
+    """
+
+    def __init__(self, ipcon, key, function_id, form_ret, timeout, convert):
+        self.ipcon = ipcon
+        self.key = key # (uid, function_id, sequence_number), None if no response is expected
+        self.function_id = function_id
+        self.form_ret = form_ret
+        self.convert = convert
+        self.deadline = time.time() + timeout
+        self.event = threading.Event()
+        self.response = None # protected by ipcon.pending_requests_lock
+        self.error = None # protected by ipcon.pending_requests_lock
+
+    def done(self):
+        """
+        Returns *True* if the response arrived or the request failed.
+        """
+        return self.event.is_set()
+
+    def result(self, timeout=None):
+        """
+        Waits for the response and returns the same value as the synchronous
+        function. Raises the same errors, Error.TIMEOUT if the response did
+        not arrive within the timeout of the request. If *timeout* is given
+        and expires first, Error.TIMEOUT is raised but the request stays in
+        flight and result can be called again.
+        """
+        remaining = self.deadline - time.time()
+
+        if timeout is not None and timeout < remaining:
+            if not self.event.wait(max(timeout, 0)):
+                msg = 'Response for function {0} not received yet'.format(self.function_id)
+                raise Error(Error.TIMEOUT, msg)
+        elif not self.event.wait(max(remaining, 0)):
+            self.ipcon.expire_request(self)
+
+        if self.error is not None:
+            raise self.error
+
+        if self.response is None:
+            return None
+
+        value = unpack_response(self.function_id, self.response, self.form_ret)
+
+        if self.convert is not None:
+            return self.convert(value)
+
+        return value
+
+    def set_response(self, response):
+        # NOTE: assumes that ipcon.pending_requests_lock is locked
+        if not self.event.is_set():
+            self.response = response
+            self.event.set()
+
+    def set_error(self, error):
+        # NOTE: assumes that ipcon.pending_requests_lock is locked
+        if not self.event.is_set():
+            self.error = error
+            self.event.set()
+
 class Device(object):
     RESPONSE_EXPECTED_INVALID_FUNCTION_ID = 0
     RESPONSE_EXPECTED_ALWAYS_TRUE = 1 # getter
@@ -540,6 +674,8 @@ class IPConnection(object):
         self.connect_failure_callback = None
         self.sequence_number_lock = threading.Lock()
         self.next_sequence_number = 0 # protected by sequence_number_lock
+        self.pending_requests_lock = threading.Condition()
+        self.pending_requests = {} # protected by pending_requests_lock
         self.authentication_lock = threading.Lock() # protects authentication handshake
         self.next_authentication_nonce = 0 # protected by authentication_lock
         self.devices = {}
@@ -931,15 +1067,18 @@ class IPConnection(object):
         self.socket.close()
         self.socket = None
 
+        # requests in flight will not get a response anymore
+        self.fail_pending_requests(Error(Error.NOT_CONNECTED, 'Not connected'))
+
     def set_auto_reconnect_internal(self, auto_reconnect, connect_failure_callback):
         self.auto_reconnect_internal = auto_reconnect
         self.connect_failure_callback = connect_failure_callback
 
     def receive_loop(self, socket_id):
-        if sys.hexversion < 0x03000000:
-            pending_data = ''
-        else:
-            pending_data = bytes()
+        # Received data is collected in one buffer and packets are located in
+        # it by offset. Only complete packets are copied out of the buffer,
+        # the consumed part is dropped once per recv call
+        pending_data = bytearray()
 
         while self.receive_flag:
             try:
@@ -961,23 +1100,29 @@ class IPConnection(object):
                 break
 
             pending_data += data
+            pending_view = memoryview(pending_data)
+            offset = 0
 
             while self.receive_flag:
-                if len(pending_data) < 8:
+                if len(pending_data) - offset < 8:
                     # Wait for complete header
                     break
 
-                length = get_length_from_data(pending_data)
+                length = get_length_from_data(pending_data, offset)
 
-                if len(pending_data) < length:
+                if len(pending_data) - offset < length:
                     # Wait for complete packet
                     break
 
-                packet = pending_data[0:length]
-                pending_data = pending_data[length:]
+                packet = pending_view[offset:offset + length].tobytes()
+                offset += length
 
                 self.handle_response(packet)
 
+            # The buffer can't be resized while a view on it exists
+            del pending_view
+            del pending_data[:offset]
+
     def dispatch_meta(self, function_id, parameter, socket_id):
         if function_id == IPConnection.CALLBACK_CONNECTED:
             if IPConnection.CALLBACK_CONNECTED in self.registered_callbacks:
@@ -1034,13 +1179,12 @@ class IPConnection(object):
         uid = get_uid_from_data(packet)
         length = get_length_from_data(packet)
         function_id = get_function_id_from_data(packet)
-        payload = packet[8:]
 
         if function_id == IPConnection.CALLBACK_ENUMERATE and \
            IPConnection.CALLBACK_ENUMERATE in self.registered_callbacks:
             uid, connected_uid, position, hardware_version, \
                 firmware_version, device_identifier, enumeration_type = \
-                unpack_payload(payload, '8s 8s c 3B 3B H B')
+                unpack_payload(packet, '8s 8s c 3B 3B H B', 8)
 
             cb = self.registered_callbacks[IPConnection.CALLBACK_ENUMERATE]
             cb(uid, connected_uid, position, hardware_version,
@@ -1055,7 +1199,7 @@ class IPConnection(object):
         if -function_id in device.high_level_callbacks:
             hlcb = device.high_level_callbacks[-function_id] # [roles, options, data]
             form = device.callback_formats[function_id] # FIXME: currently assuming that form is longer than 1
-            llvalues = unpack_payload(payload, form)
+            llvalues = unpack_payload(packet, form, 8)
             has_data = False
             data = None
 
@@ -1112,9 +1256,9 @@ class IPConnection(object):
             if len(form) == 0:
                 cb()
             elif len(form.split(' ')) == 1:
-                cb(unpack_payload(payload, form))
+                cb(unpack_payload(packet, form, 8))
             else:
-                cb(*unpack_payload(payload, form))
+                cb(*unpack_payload(packet, form, 8))
 
     def callback_loop(self, callback):
         while True:
@@ -1180,24 +1324,18 @@ class IPConnection(object):
 
             self.disconnect_probe_flag = False
 
-    def send_request(self, device, function_id, data, form, form_ret):
-        patched_from = []
+    def create_request(self, device, function_id, data, form, sequence_number=None):
+        codec = get_payload_codec(form)
+        request, response_expected, sequence_number = \
+            self.create_packet_header(device, 8 + codec.size, function_id, sequence_number)
 
-        for f in form.split(' '):
-            if '!' in f:
-                if len(f) > 1:
-                    patched_from.append('{0}B'.format(int(math.ceil(int(f.replace('!', '')) / 8.0))))
-                else:
-                    patched_from.append('?')
-            else:
-                patched_from.append(f)
+        request += codec.pack(data)
 
-        patched_from = '<' + ' '.join(patched_from)
-        length = 8 + struct.calcsize(patched_from)
-        request, response_expected, sequence_number = \
-            self.create_packet_header(device, length, function_id)
+        return request, response_expected, sequence_number
 
-        request += pack_payload(data, form)
+    def send_request(self, device, function_id, data, form, form_ret):
+        request, response_expected, sequence_number = \
+            self.create_request(device, function_id, data, form)
 
         if response_expected:
             with device.request_lock:
@@ -1222,25 +1360,98 @@ class IPConnection(object):
                     device.expected_response_function_id = None
                     device.expected_response_sequence_number = None
 
-            error_code = get_error_code_from_data(response)
+            return unpack_response(function_id, response, form_ret)
+        else:
+            self.send(request)
 
-            if error_code == 0:
-                # no error
-                pass
-            elif error_code == 1:
-                msg = 'Got invalid parameter for function {0}'.format(function_id)
-                raise Error(Error.INVALID_PARAMETER, msg)
-            elif error_code == 2:
-                msg = 'Function {0} is not supported'.format(function_id)
-                raise Error(Error.NOT_SUPPORTED, msg)
-            else:
-                msg = 'Function {0} returned an unknown error'.format(function_id)
-                raise Error(Error.UNKNOWN_ERROR_CODE, msg)
+    def send_request_async(self, device, function_id, data, form, form_ret, timeout=None, convert=None):
+        """
+        Sends a request without waiting for the response and returns a
+        :class:`Future` for it. Any number of requests can be in flight,
+        to the same or to different devices. *timeout* (in seconds, default
+        is the timeout of the connection) applies to this request only,
+        *convert* is applied to the unpacked response (e.g. a namedtuple).
+
+        The sequence number of a request is chosen so that no other request
+        with the same UID and function ID and that sequence number is in
+        flight. If all 15 sequence numbers are in use for this function of
+        the device, the call blocks until a response arrives or a request
+        times out. Requests with the same function ID should not be sent
+        to the same device with send_request at the same time.
+        """
+        if timeout is None:
+            timeout = self.timeout
 
-            if len(form_ret) > 0:
-                return unpack_payload(response[8:], form_ret)
-        else:
+        if not device.get_response_expected(function_id):
+            request, _, _ = self.create_request(device, function_id, data, form)
+            future = Future(self, None, function_id, form_ret, timeout, convert)
+
+            self.send(request)
+
+            with self.pending_requests_lock:
+                future.set_response(None)
+
+            return future
+
+        with self.pending_requests_lock:
+            while True:
+                now = time.time()
+                next_deadline = None
+
+                for _ in range(15):
+                    sequence_number = self.get_next_sequence_number()
+                    key = (device.uid, function_id, sequence_number)
+                    other = self.pending_requests.get(key)
+
+                    if other is None:
+                        break
+
+                    if other.deadline <= now:
+                        self.expire_request_unlocked(other)
+                        break
+
+                    if next_deadline is None or other.deadline < next_deadline:
+                        next_deadline = other.deadline
+                else:
+                    self.pending_requests_lock.wait(max(next_deadline - now, 0))
+                    continue
+
+                future = Future(self, key, function_id, form_ret, timeout, convert)
+                self.pending_requests[key] = future
+                break
+
+        request, _, _ = self.create_request(device, function_id, data, form, sequence_number)
+
+        try:
             self.send(request)
+        except Error as e:
+            with self.pending_requests_lock:
+                self.pending_requests.pop(key, None)
+                self.pending_requests_lock.notify_all()
+                future.set_error(e)
+
+        return future
+
+    def expire_request(self, future):
+        with self.pending_requests_lock:
+            self.expire_request_unlocked(future)
+
+    def expire_request_unlocked(self, future):
+        # NOTE: assumes that pending_requests_lock is locked
+        if self.pending_requests.get(future.key) is future:
+            del self.pending_requests[future.key]
+            self.pending_requests_lock.notify_all()
+
+        msg = 'Did not receive response for function {0} in time'.format(future.function_id)
+        future.set_error(Error(Error.TIMEOUT, msg))
+
+    def fail_pending_requests(self, error):
+        with self.pending_requests_lock:
+            for future in self.pending_requests.values():
+                future.set_error(error)
+
+            self.pending_requests = {}
+            self.pending_requests_lock.notify_all()
 
     def get_next_sequence_number(self):
         with self.sequence_number_lock:
@@ -1278,6 +1489,14 @@ class IPConnection(object):
             device.response_queue.put(packet)
             return
 
+        with self.pending_requests_lock:
+            future = self.pending_requests.pop((uid, function_id, sequence_number), None)
+
+            if future is not None:
+                future.set_response(packet)
+                self.pending_requests_lock.notify_all()
+                return
+
         # Response seems to be OK, but can't be handled
 
     def handle_disconnect_by_peer(self, disconnect_reason, socket_id, disconnect_immediately):
@@ -1292,11 +1511,14 @@ class IPConnection(object):
                                  (IPConnection.CALLBACK_DISCONNECTED,
                                   disconnect_reason, socket_id)))
 
-    def create_packet_header(self, device, length, function_id):
+    def create_packet_header(self, device, length, function_id, sequence_number=None):
         uid = IPConnection.BROADCAST_UID
-        sequence_number = self.get_next_sequence_number()
         r_bit = 0
 
+        if sequence_number is None:
+            sequence_number = self.get_next_sequence_number()
+
+
         if device is not None:
             uid = device.uid
 
@@ -1305,7 +1527,7 @@ class IPConnection(object):
 
         sequence_number_and_options = (sequence_number << 4) | (r_bit << 3)
 
-        return (struct.pack('<IBBBB', uid, length, function_id,
+        return (HEADER_STRUCT.pack(uid, length, function_id,
                             sequence_number_and_options, 0),
                 bool(r_bit),
                 sequence_number)
@@ -0,0 +1,96 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+HOST = "localhost"
+PORT = 4223
+UID = "XYZ"
+INTERVAL = 0.5 # Seconds between polls, the buffer holds 32 events
+
+import struct
+import time
+
+from tinkerforge.ip_connection import IPConnection
+from tinkerforge.bricklet_gas import BrickletGas
+
+# Drains the binary trace buffer of the Bricklet and prints the decoded
+# events. The event IDs have to match software/src/trace.h.
+
+EVENT_SIZE = 12
+
+def decode_mcp3423_raw(a, b):
+    return "raw {0:02x} {1:02x} {2:02x} {3:02x}".format((a >> 16) & 0xFF, (a >> 8) & 0xFF, a & 0xFF, b & 0xFF)
+
+def decode_lmp91000_mismatch(a, b):
+    return "register {0:02x} is {1:02x} instead of {2:02x}".format(a, (b >> 8) & 0xFF, b & 0xFF)
+
+DIAGNOSTIC_STATUS = {0: "not run", 1: "ok", 2: "register error", 3: "no response", 4: "saturated", 5: "not recovered"}
+
+def decode_i2c_error(a, b):
+    return "status {0:x}, address {1:02x}, attempt {2}".format(a & 0xFFFFFFFF, (b >> 8) & 0xFF, b & 0xFF)
+
+EVENTS = {
+    1: ("MCP3423_RAW",           decode_mcp3423_raw),
+    2: ("MCP3423_ADC_COUNT",     lambda a, b: "adc count {0}".format(a)),
+    3: ("HDC1080",               lambda a, b: "temperature {0:.2f} °C, humidity {1:.2f} %RH".format(a/100.0, b/100.0)),
+    4: ("GAS_CONCENTRATION",     lambda a, b: "{0:.3f} ppb, slope {1} ppb/min".format(a/1000.0, b)),
+    5: ("LMP91000_REGISTER",     lambda a, b: "register {0:02x} -> {1:02x}".format(a, b)),
+    6: ("LMP91000_MISMATCH",     decode_lmp91000_mismatch),
+    7: ("I2C_ERROR",             decode_i2c_error),
+    9: ("OUTLIER",               lambda a, b: "adc count {0} rejected, median {1}".format(a, b)),
+    10: ("BASELINE",             lambda a, b: "quiet block mean {0:.2f}, offset {1:.2f} adc counts".format(a/256.0, b/256.0)),
+    12: ("DIAGNOSTIC",           lambda a, b: "status {0}, bias step response {1} adc counts".format(DIAGNOSTIC_STATUS.get(a, a), b)),
+    13: ("WATCHDOG",             lambda a, b: "measurement task restarted, adc count age {0} ms, temperature/humidity age {1} ms".format(a, b)),
+}
+
+class TimeUnwrapper:
+    # The firmware only sends the lower 16 bit of the time in ms
+    def __init__(self):
+        self.last = None
+        self.offset = 0
+
+    def unwrap(self, time16):
+        if self.last is not None and time16 < self.last:
+            self.offset += 1 << 16
+
+        self.last = time16
+
+        return self.offset + time16
+
+def decode_events(data, length, unwrapper):
+    events = []
+
+    for i in range(length):
+        time16, event_id, _, arg0, arg1 = struct.unpack('<HBBii', bytes(bytearray(data[i*EVENT_SIZE:(i+1)*EVENT_SIZE])))
+        name, decode = EVENTS.get(event_id, ("UNKNOWN_{0}".format(event_id), lambda a, b: "{0} {1}".format(a, b)))
+        events.append((unwrapper.unwrap(time16), name, decode(arg0, arg1)))
+
+    return events
+
+if __name__ == "__main__":
+    ipcon = IPConnection() # Create IP connection
+    gas = BrickletGas(UID, ipcon) # Create device object
+
+    ipcon.connect(HOST, PORT) # Connect to brickd
+    # Don't use device before ipcon is connected
+
+    unwrapper = TimeUnwrapper()
+
+    try:
+        while True:
+            while True:
+                trace = gas.read_trace()
+
+                if trace.events_lost > 0:
+                    print("{0} events lost".format(trace.events_lost))
+
+                for t, name, text in decode_events(trace.events_data, trace.events_length, unwrapper):
+                    print("{0:10d} ms {1:22s} {2}".format(t, name, text))
+
+                if trace.events_length == 0:
+                    break
+
+            time.sleep(INTERVAL)
+    except KeyboardInterrupt:
+        pass
+
+    ipcon.disconnect()